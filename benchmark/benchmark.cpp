@@ -2,8 +2,10 @@
 #include <cstdlib>
 #include <string>
 #include <random>
+#include <future>
+#include <thread>
 
-#include "core/BST.hpp"
+#include "core/SkipList.hpp"
 #include "builder/DefaultSupermap.hpp"
 #include "primitive/Key.hpp"
 #include "primitive/ByteArray.hpp"
@@ -48,7 +50,7 @@ class Benchmark {
         auto backendKvs = SupermapBuilder::build(
             10,
             std::make_unique<supermap::XXHasher>(),
-            std::make_unique<supermap::BST<K, I, I>>(),
+            std::make_unique<supermap::SkipList<K, I, I>>(),
             supermapParams
         );
 
@@ -130,7 +132,128 @@ class Benchmark {
         return result;
     }
 
+    struct ThroughputResult {
+        std::size_t threads{};
+        std::uint64_t lockingRequestsPerSecond{};
+        std::uint64_t executorRequestsPerSecond{};
+    };
+
+    /**
+     * @brief Measures throughput of sharded storage, which is used by @p 1, @p 2, @p 4, ... @p maxThreads
+     * threads at once, in the locking mode and in the executor mode.
+     */
+    std::vector<ThroughputResult> benchmarkThroughput(std::int64_t initialNumberOfElements,
+                                                      std::int64_t numberOfRequests,
+                                                      std::int64_t percentageOfGetRequests,
+                                                      std::size_t maxThreads) {
+        auto supermapParams = ThroughputBuilder::BuildParameters{
+            static_cast<unsigned long>(initialNumberOfElements / 10 + 1),
+            0.5,
+            "supermap-locking",
+            1 / 32.0
+        };
+        auto locking = ThroughputBuilder::build(
+            THROUGHPUT_SHARDS,
+            std::make_unique<supermap::XXHasher>(),
+            std::make_unique<supermap::SkipList<K, I, I>>(),
+            supermapParams
+        );
+        supermapParams.folderName = "supermap-executor";
+        auto executor = ThroughputBuilder::buildExecutor(
+            THROUGHPUT_SHARDS,
+            std::make_unique<supermap::XXHasher>(),
+            std::make_unique<supermap::SkipList<K, I, I>>(),
+            supermapParams
+        );
+        for (std::int64_t k = 0; k < initialNumberOfElements; ++k) {
+            KV keyValue = makeKeyValue(std::to_string(k));
+            locking->add(keyValue.key, V(keyValue.value));
+            executor->add(keyValue.key, std::move(keyValue.value));
+        }
+
+        std::vector<ThroughputResult> results;
+        for (std::size_t threads = 1; threads <= maxThreads; threads *= 2) {
+            const std::int64_t requestsPerThread =
+                std::max<std::int64_t>(1, numberOfRequests / static_cast<std::int64_t>(threads));
+            std::uint64_t lockingMicros = measureThreads(threads, [&](std::mt19937 &rnd) {
+                for (std::int64_t k = 0; k < requestsPerThread; ++k) {
+                    KV keyValue = makeKeyValue(std::to_string(rnd() % (initialNumberOfElements + 1)));
+                    if (static_cast<std::int64_t>(rnd() % 100) < percentageOfGetRequests) {
+                        locking->getValue(keyValue.key);
+                    } else {
+                        locking->add(keyValue.key, std::move(keyValue.value));
+                    }
+                }
+            });
+            std::uint64_t executorMicros = measureThreads(threads, [&](std::mt19937 &rnd) {
+                std::vector<std::future<std::optional<V>>> gets;
+                std::vector<std::future<void>> adds;
+                for (std::int64_t k = 0; k < requestsPerThread; ++k) {
+                    KV keyValue = makeKeyValue(std::to_string(rnd() % (initialNumberOfElements + 1)));
+                    if (static_cast<std::int64_t>(rnd() % 100) < percentageOfGetRequests) {
+                        gets.push_back(executor->getValueAsync(keyValue.key));
+                    } else {
+                        adds.push_back(executor->addAsync(keyValue.key, std::move(keyValue.value)));
+                    }
+                    if (gets.size() + adds.size() == THROUGHPUT_WINDOW) {
+                        waitAll(gets, adds);
+                    }
+                }
+                waitAll(gets, adds);
+            });
+            std::uint64_t requests = requestsPerThread * threads * 1000000;
+            results.push_back({threads,
+                               requests / std::max<std::uint64_t>(lockingMicros, 1),
+                               requests / std::max<std::uint64_t>(executorMicros, 1)});
+        }
+        return results;
+    }
+
   private:
+    using ThroughputBuilder = supermap::ShardedSupermapBuilder<K, V, I>;
+
+    static constexpr std::size_t THROUGHPUT_SHARDS = 10;
+
+    /**
+     * @brief Number of requests, which one thread keeps in flight in the executor mode.
+     */
+    static constexpr std::size_t THROUGHPUT_WINDOW = 64;
+
+    template <typename Job>
+    static std::uint64_t measureThreads(std::size_t threads, Job job) {
+        std::vector<std::thread> workers;
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        for (std::size_t thread = 0; thread < threads; ++thread) {
+            workers.emplace_back([&job, thread]() {
+                std::mt19937 rnd(thread);
+                job(rnd);
+            });
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count();
+    }
+
+    static void waitAll(std::vector<std::future<std::optional<V>>> &gets, std::vector<std::future<void>> &adds) {
+        for (auto &future : gets) {
+            future.get();
+        }
+        for (auto &future : adds) {
+            future.get();
+        }
+        gets.clear();
+        adds.clear();
+    }
+
+    static KV makeKeyValue(std::string keyString) {
+        std::string valueString = keyString;
+        keyString.resize(KEY_SIZE);
+        valueString.resize(VALUE_SIZE);
+        return KV{K::fromString(keyString), V::fromString(valueString)};
+    }
+
     std::uint64_t measureAddRequest() {
         KV keyValue = getRandomKeyValue();
         std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
@@ -175,7 +298,7 @@ void printParametersErrorMessage() {
 }
 
 int main(int argc, char *argv[]) {
-    if (argc != 4) {
+    if (argc != 4 && argc != 5) {
         printParametersErrorMessage();
         return 1;
     }
@@ -191,6 +314,24 @@ int main(int argc, char *argv[]) {
     }
 
     Benchmark benchmark;
+    if (argc == 5) {
+        std::int64_t maxThreads = std::strtol(argv[4], nullptr, 10);
+        if (maxThreads <= 0) {
+            printParametersErrorMessage();
+            return 1;
+        }
+        auto results = benchmark.benchmarkThroughput(initialNumberOfElements,
+                                                     numberOfRequests,
+                                                     percentageOfGetRequests,
+                                                     static_cast<std::size_t>(maxThreads));
+        std::cout << "threads lockingRequestsPerSecond executorRequestsPerSecond" << std::endl;
+        for (const auto &result : results) {
+            std::cout << result.threads << ' '
+                      << result.lockingRequestsPerSecond << ' '
+                      << result.executorRequestsPerSecond << std::endl;
+        }
+        return 0;
+    }
     auto result = benchmark.benchmarkKVS(initialNumberOfElements, numberOfRequests, percentageOfGetRequests);
     std::cout << "averageRequestTimeInMicros " << result.averageRequestTimeInMicros << std::endl;
     std::cout << "averageGetRequestTimeInMicros " << result.averageGetRequestTimeInMicros << std::endl;
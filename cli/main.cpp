@@ -3,7 +3,7 @@
 
 #include "CommandLineInterface.hpp"
 #include "KvsCommandHandler.hpp"
-#include "core/BST.hpp"
+#include "core/SkipList.hpp"
 #include "io/DiskFileManager.hpp"
 #include "builder/DefaultSupermap.hpp"
 #include "primitive/Key.hpp"
@@ -29,7 +29,7 @@ int main(int, const char **) {
     };
 
     auto backendKvs = SupermapBuilder::build(
-        std::make_unique<supermap::BST<K, I, I>>(),
+        std::make_unique<supermap::SkipList<K, I, I>>(),
         supermapParams
     );
 
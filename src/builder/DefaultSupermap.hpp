@@ -1,11 +1,18 @@
 #pragma once
 
+#include <filesystem>
 #include <memory>
+#include <optional>
 
 #include "core/Supermap.hpp"
 #include "io/DiskFileManager.hpp"
+#include "io/MmapFileManager.hpp"
 #include "io/EncapsulatedFileManager.hpp"
+#include "io/PinningFileManager.hpp"
 #include "core/BloomFilter.hpp"
+#include "core/BlockedBloomFilter.hpp"
+#include "core/PolicyDrivenFilter.hpp"
+#include "core/XorFilter.hpp"
 #include "core/KeyHashingShardedKVS.hpp"
 
 namespace supermap {
@@ -17,11 +24,43 @@ template <
 >
 class DefaultSupermap {
   public:
+    /**
+     * @brief Kind of filters of the disk index storages.
+     */
+    enum class FilterKind {
+        /**
+         * @brief @p BloomFilter.
+         */
+        BLOOM,
+
+        /**
+         * @brief @p BlockedBloomFilter, which checks a single cache line per lookup.
+         */
+        BLOCKED_BLOOM,
+
+        /**
+         * @brief @p XorFilter, which is built once the index storage is complete.
+         * It has fixed false positive probability 1/256, so error probability and bits per key are ignored.
+         */
+        XOR,
+    };
+
     struct BuildParameters {
         IndexT batchSize;
         double maxNotSortedPart{};
         std::string folderName;
         double errorProbability{};
+        bool memoryMapped = false;
+        std::shared_ptr<io::BlockCache> blockCache{};
+        bool backgroundCompaction = false;
+        bool backgroundShrink = false;
+        std::size_t appendBufferBytes = 64 * 1024;
+        std::optional<io::WalSyncPolicy> writeAheadLog{};
+        bool persistent = false;
+        FilterKind filterKind = FilterKind::BLOOM;
+        double bitsPerKey = 0;
+        bool monkeyFilterPolicy = false;
+        std::size_t maxImmutableMemtables = 0;
     };
 
   public:
@@ -39,64 +78,204 @@ class DefaultSupermap {
     using RegisterInfo = typename Smap::RegisterInfo;
     using Register = typename Smap::RegisterBase;
     using DefaultBinaryCollapsingList = BinaryCollapsingSortedStoragesList<KI, I, RegisterInfo, K>;
+    using ManifestType = typename Smap::ManifestType;
 
   private:
     using KVS = KeyValueStorage<Key, Value, IndexT>;
 
+    static constexpr const char *WRITE_AHEAD_LOG_NAME = "write-ahead-log";
+
   public:
+    /**
+     * @brief Builds Supermap in the folder @p params.folderName.
+     * @throws IllegalArgumentException if write-ahead log is enabled, but storage is not persistent:
+     * only checkpoints of persistent storage clear the log.
+     */
     static std::unique_ptr<KVS> build(
         std::unique_ptr<RamStorageBase> &&nested,
         const BuildParameters &params
     ) {
-        std::shared_ptr<supermap::io::FileManager> fileManager
-            = std::make_shared<supermap::io::EncapsulatedFileManager>(
+        if (params.writeAheadLog.has_value() && !params.persistent) {
+            throw IllegalArgumentException("Write-ahead log requires persistent storage");
+        }
+        std::unique_ptr<supermap::io::FileManager> folderFileManager
+            = std::make_unique<supermap::io::EncapsulatedFileManager>(
                 std::make_shared<supermap::io::TemporaryFolder>(params.folderName, true),
-                std::make_unique<supermap::io::DiskFileManager>()
+                params.memoryMapped
+                ? std::make_unique<supermap::io::MmapFileManager>(
+                    supermap::io::DiskFileManager::DEFAULT_MAX_OPEN_FILES,
+                    params.blockCache
+                )
+                : std::make_unique<supermap::io::DiskFileManager>(
+                    supermap::io::DiskFileManager::DEFAULT_MAX_OPEN_FILES,
+                    params.blockCache
+                )
             );
+        std::shared_ptr<supermap::io::PinningFileManager> persistentFileManager
+            = params.persistent
+              ? std::make_shared<supermap::io::PinningFileManager>(std::move(folderFileManager))
+              : nullptr;
+        std::shared_ptr<supermap::io::FileManager> fileManager
+            = persistentFileManager
+              ? persistentFileManager
+              : std::shared_ptr<supermap::io::FileManager>(std::move(folderFileManager));
+
+        std::optional<ManifestType> manifest;
+        if (persistentFileManager) {
+            manifest = ManifestType::read(*persistentFileManager);
+            std::unordered_set<std::string> referencedFiles;
+            if (manifest.has_value()) {
+                referencedFiles = manifest->getReferencedFiles();
+            }
+            removeUnreferencedFiles(*persistentFileManager, params.folderName, referencedFiles);
+            persistentFileManager->pin(std::move(referencedFiles));
+        }
 
         std::function<std::unique_ptr<IndexStorageBase>(IndexStorageBase &&)>
             indexSupplier = [](IndexStorageBase &&sortedStorage) {
             return std::make_unique<FilteredIndexStorage>(std::move(sortedStorage));
         };
 
+        std::shared_ptr<FilterPolicy> filterPolicy
+            = params.monkeyFilterPolicy
+              ? std::make_shared<MonkeyFilterPolicy>(
+                params.bitsPerKey > 0 ? params.bitsPerKey : -1.44 * std::log2(params.errorProbability))
+              : nullptr;
+
         std::function<std::unique_ptr<Register>()>
-            innerRegisterSupplier = [errorProbability = params.errorProbability]() {
+            innerRegisterSupplier = [errorProbability = params.errorProbability,
+                                     bitsPerKey = params.bitsPerKey,
+                                     filterKind = params.filterKind,
+                                     filterPolicy]() {
             return std::make_unique<FilteringRegister<KI, K>>(
-                [errorProbability = errorProbability]() {
-                    return std::make_unique<BloomFilter<K>>(
-                        errorProbability,
-                        std::make_unique<XXHasher>()
-                    );
+                [errorProbability, bitsPerKey, filterKind, filterPolicy]() -> std::unique_ptr<Filter<K>> {
+                    if (filterPolicy) {
+                        return std::make_unique<PolicyDrivenFilter<K>>(
+                            filterPolicy,
+                            [filterKind](double policyBitsPerKey) {
+                                return makeFilter(filterKind, 1, policyBitsPerKey);
+                            }
+                        );
+                    }
+                    return makeFilter(filterKind, errorProbability, bitsPerKey);
                 },
                 [](const KI &ki) { return ki.key; }
             );
         };
 
         std::function<std::unique_ptr<IndexStorageListBase>()>
-            indexListSupplier = [maxRamLoad = params.batchSize, registerSupplier = innerRegisterSupplier]() {
+            indexListSupplier = [maxRamLoad = params.batchSize,
+                                 registerSupplier = innerRegisterSupplier,
+                                 backgroundCompaction = params.backgroundCompaction,
+                                 indexSupplier]() {
             return std::make_unique<DefaultBinaryCollapsingList>(
                 maxRamLoad,
-                registerSupplier
+                registerSupplier,
+                backgroundCompaction,
+                indexSupplier
             );
         };
 
         return std::unique_ptr<KVS>(
             new Smap(
                 std::move(nested),
-                std::make_unique<DiskStorage>(
+                manifest.has_value()
+                ? std::make_unique<DiskStorage>(
+                    manifest->notSortedPath,
+                    manifest->notSortedItemsCount,
+                    manifest->sortedPath,
+                    manifest->sortedItemsCount,
+                    fileManager,
+                    innerRegisterSupplier,
+                    manifest->notSortedBase,
+                    params.appendBufferBytes
+                )
+                : std::make_unique<DiskStorage>(
                     "storage-not-sorted",
                     "storage-sorted",
                     fileManager,
-                    innerRegisterSupplier
+                    innerRegisterSupplier,
+                    0,
+                    params.appendBufferBytes
                 ),
                 indexSupplier,
                 indexListSupplier,
                 innerRegisterSupplier,
                 params.batchSize,
-                params.maxNotSortedPart
+                params.maxNotSortedPart,
+                params.backgroundShrink,
+                params.writeAheadLog.has_value()
+                ? std::make_unique<io::WriteAheadLog<KeyValue<K, V>>>(
+                    fileManager,
+                    WRITE_AHEAD_LOG_NAME,
+                    params.writeAheadLog.value()
+                )
+                : nullptr,
+                persistentFileManager,
+                manifest,
+                filterPolicy,
+                params.maxImmutableMemtables
             )
         );
     }
+
+  private:
+    /**
+     * @brief Creates index filter.
+     * @param filterKind Kind of the filter.
+     * @param errorProbability Desired false positive probability.
+     * @param bitsPerKey Number of filter bits per key. If positive, overrides @p errorProbability.
+     * @return Created filter.
+     */
+    static std::unique_ptr<Filter<K>> makeFilter(FilterKind filterKind, double errorProbability, double bitsPerKey) {
+        if (filterKind == FilterKind::XOR) {
+            return std::make_unique<XorFilter<K>>(std::make_unique<XXHasher>());
+        }
+        if (filterKind == FilterKind::BLOCKED_BLOOM) {
+            return makeFilter<BlockedBloomFilter<K>>(errorProbability, bitsPerKey);
+        }
+        return makeFilter<BloomFilter<K>>(errorProbability, bitsPerKey);
+    }
+
+    /**
+     * @brief Creates index filter of type @p FilterT.
+     * @param errorProbability Desired false positive probability.
+     * @param bitsPerKey Number of filter bits per key. If positive, overrides @p errorProbability.
+     * @return Created filter.
+     */
+    template <typename FilterT>
+    static std::unique_ptr<Filter<K>> makeFilter(double errorProbability, double bitsPerKey) {
+        if (bitsPerKey > 0) {
+            return std::make_unique<FilterT>(FilterT::withBitsPerElement(bitsPerKey, std::make_unique<XXHasher>()));
+        }
+        return std::make_unique<FilterT>(errorProbability, std::make_unique<XXHasher>());
+    }
+
+    /**
+     * @brief Removes files of @p folder, which are left by the previous run of persistent storage,
+     * but are not referenced by its manifest: files created after the last checkpoint
+     * and files, which removal was postponed.
+     * @param fileManager Manager of the @p folder files.
+     * @param folder Storage folder.
+     * @param referencedFiles Files referenced by the manifest.
+     */
+    static void removeUnreferencedFiles(io::FileManager &fileManager,
+                                        const std::string &folder,
+                                        const std::unordered_set<std::string> &referencedFiles) {
+        std::vector<std::string> unreferenced;
+        for (const auto &entry : std::filesystem::directory_iterator(folder)) {
+            std::string name = entry.path().filename().string();
+            if (entry.is_regular_file()
+                && referencedFiles.count(name) == 0
+                && name != ManifestType::FILE_NAME
+                && name != WRITE_AHEAD_LOG_NAME) {
+                unreferenced.push_back(std::move(name));
+            }
+        }
+        for (const auto &name : unreferenced) {
+            fileManager.remove(name);
+        }
+    }
 };
 
 } // supermap
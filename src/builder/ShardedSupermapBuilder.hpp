@@ -2,6 +2,7 @@
 
 #include "DefaultSupermap.hpp"
 #include "core/KeyHashingShardedKVS.hpp"
+#include "core/ExecutorShardedKVS.hpp"
 
 namespace supermap {
 
@@ -20,6 +21,36 @@ class ShardedSupermapBuilder {
         std::unique_ptr<Hasher> &&hasher,
         std::unique_ptr<NestedKvs> &&nested,
         const BuildParameters &params
+    ) {
+        return std::make_unique<KeyHashingShardedKVS<Key, Value, IndexT>>(
+            buildShards(nShards, std::move(nested), params),
+            std::move(hasher)
+        );
+    }
+
+    /**
+     * @brief Builds sharded storage in executor mode, where every shard is owned by its own worker thread.
+     * @param pinWorkers If worker threads should be pinned to CPU cores.
+     */
+    static std::unique_ptr<ExecutorShardedKVS<Key, Value, IndexT>> buildExecutor(
+        std::size_t nShards,
+        std::unique_ptr<Hasher> &&hasher,
+        std::unique_ptr<NestedKvs> &&nested,
+        const BuildParameters &params,
+        bool pinWorkers = true
+    ) {
+        return std::make_unique<ExecutorShardedKVS<Key, Value, IndexT>>(
+            buildShards(nShards, std::move(nested), params),
+            std::move(hasher),
+            pinWorkers
+        );
+    }
+
+  private:
+    static std::vector<std::unique_ptr<KVS>> buildShards(
+        std::size_t nShards,
+        std::unique_ptr<NestedKvs> &&nested,
+        const BuildParameters &params
     ) {
         std::vector<std::unique_ptr<NestedKvs>> nestedStorages(nShards);
         nestedStorages[0] = std::move(nested);
@@ -28,21 +59,14 @@ class ShardedSupermapBuilder {
         }
         std::vector<std::unique_ptr<KVS>> storages(nShards);
         for (std::size_t shard = 0; shard < nShards; ++shard) {
+            BuildParameters shardParams = params;
+            shardParams.folderName = std::filesystem::path(params.folderName) / std::to_string(shard);
             storages[shard] = DefaultSupermap<Key, Value, IndexT>::build(
                 std::move(nestedStorages[shard]),
-                BuildParameters{
-                    params.batchSize,
-                    params.maxNotSortedPart,
-                    std::filesystem::path(params.folderName) / std::to_string(shard),
-                    params.errorProbability,
-                }
+                shardParams
             );
         }
-
-        return std::make_unique<KeyHashingShardedKVS<Key, Value, IndexT>>(
-            std::move(storages),
-            std::move(hasher)
-        );
+        return storages;
     }
 };
 
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace supermap {
+
+/**
+ * @brief Bump allocator, which takes memory from the heap by large blocks,
+ * and frees all allocated memory at once. Allocated objects are never destroyed by the arena.
+ * Allocated memory stays valid until the arena is cleared or destroyed.
+ */
+class Arena {
+  public:
+    /**
+     * @brief Size of the memory block, which is taken from the heap at once.
+     */
+    static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+    Arena() = default;
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+    Arena(Arena &&) noexcept = default;
+    Arena &operator=(Arena &&) noexcept = default;
+
+    /**
+     * @brief Allocates @p bytes bytes of uninitialized memory.
+     * @param bytes Size of memory.
+     * @param alignment Alignment of memory, must be a power of two not bigger than @p alignof(std::max_align_t).
+     * @return Pointer to the allocated memory.
+     */
+    void *allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t)) {
+        std::size_t padding = (alignment - reinterpret_cast<std::uintptr_t>(current_) % alignment) % alignment;
+        if (padding + bytes > remaining_) {
+            if (bytes > BLOCK_SIZE / 4) {
+                return allocateBlock(bytes);
+            }
+            current_ = allocateBlock(BLOCK_SIZE);
+            remaining_ = BLOCK_SIZE;
+            padding = 0;
+        }
+        char *result = current_ + padding;
+        current_ = result + bytes;
+        remaining_ -= padding + bytes;
+        return result;
+    }
+
+    /**
+     * @brief Allocates memory for the object of type @p T and constructs it there.
+     * @param args Arguments of @p T constructor.
+     * @return Pointer to the constructed object.
+     */
+    template <typename T, typename... Args>
+    T *create(Args &&... args) {
+        return new(allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Frees all allocated memory.
+     */
+    void clear() noexcept {
+        blocks_.clear();
+        current_ = nullptr;
+        remaining_ = 0;
+        memoryUsage_ = 0;
+    }
+
+    /**
+     * @return Number of bytes, taken from the heap.
+     */
+    [[nodiscard]] std::size_t getMemoryUsage() const noexcept {
+        return memoryUsage_;
+    }
+
+  private:
+    char *allocateBlock(std::size_t bytes) {
+        blocks_.push_back(std::unique_ptr<char[]>(new char[bytes]));
+        memoryUsage_ += bytes;
+        return blocks_.back().get();
+    }
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    char *current_ = nullptr;
+    std::size_t remaining_ = 0;
+    std::size_t memoryUsage_ = 0;
+};
+
+} // supermap
@@ -30,10 +30,11 @@ class BST : public ExtractibleKeyValueStorage<Key, Value, IndexT> {
      * @return The most relevant @p Value associated with @p key.
      */
     std::optional<Value> getValue(const Key &key) override {
-        if (map_.find(key) == map_.end()) {
+        auto it = map_.find(key);
+        if (it == map_.end()) {
             return std::nullopt;
         }
-        return std::optional{map_[key]};
+        return std::optional{it->second};
     }
 
     /**
@@ -56,6 +57,15 @@ class BST : public ExtractibleKeyValueStorage<Key, Value, IndexT> {
         return extracted;
     }
 
+    /**
+     * @brief Passes all key-value pairs to @p consumer in key order.
+     */
+    void forEachSorted(const std::function<void(const KeyValue<Key, Value> &)> &consumer) const override {
+        for (const auto &[k, v] : map_) {
+            consumer(KeyValue<Key, Value>(k, v));
+        }
+    }
+
     void remove(const Key &key) override {
         map_.erase(key);
     }
@@ -1,6 +1,14 @@
 #pragma once
 
+#include <atomic>
 #include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
 
 #include "primitive/Key.hpp"
 #include "SortedStoragesList.hpp"
@@ -10,7 +18,10 @@ namespace supermap {
 /**
  * @brief List of @p SortedSingleFileIndexedStorage.
  * For each storage, the rank is determined as log_2(SIZE / @p RankOneSize ).
- * Two storages are merged if their ranks are the same.
+ * Two neighbour storages are merged if the rank of the newer one is not less then the rank of the older one.
+ * Merges may be done either by the appending thread, or by the background compaction worker.
+ * Storages are never changed after they were added to the list: merge creates a new storage,
+ * which atomically replaces merged ones, so readers always see the consistent list.
  * @tparam T Type of storage content.
  * @tparam IndexT Type of storage content index.
  * @tparam RankOneSize Size of block which have rank 1.
@@ -28,73 +39,82 @@ class BinaryCollapsingSortedStoragesList : public SortedStoragesList<T, IndexT,
     using InnerRegisterSupplier = typename SortedStorage::InnerRegisterSupplier;
 
     /**
-     * @brief A node in linked list of storages.
+     * @brief Storages, ordered from the most to the least relevant.
      */
-    struct ListNode {
-        explicit ListNode(std::unique_ptr<SortedStorage> &&s, std::shared_ptr<ListNode> n, IndexT rankOneSize)
-            : storage(std::move(s)), next(std::move(n)), rankOneSize_(rankOneSize) {}
-
-        std::unique_ptr<SortedStorage> storage;
-        std::shared_ptr<ListNode> next;
-
-        /**
-         * @return If node's storage is initialized.
-         */
-        bool valid() {
-            return storage != nullptr;
-        }
+    using Runs = std::vector<std::shared_ptr<SortedStorage>>;
 
-        /**
-         * @return Rank of corresponding storage.
-         */
-        IndexT getRank() {
-            assert(valid());
-            IndexT size = storage->getItemsCount();
-            assert(size != 0);
-            return std::log2((size + rankOneSize_ - 1) / rankOneSize_);
-        }
+  public:
+    using StorageWrapper = std::function<std::unique_ptr<SortedStorage>(SortedStorage &&)>;
 
-      private:
-        const IndexT rankOneSize_;
-    };
+    /**
+     * @brief If list consists of this number of storages, appending thread waits
+     * until background compaction worker merges some of them.
+     */
+    static constexpr std::size_t MAX_RUNS_BEFORE_STALL = 64;
 
-  public:
     /**
      * @brief Creates BinaryCollapsingSortedStoragesList.
      * @param batchSize The size of the batch of @p T objects that are simultaneously stored in RAM.
      * @param innerRegisterSupplier Supplier of registers for all inner storages.
+     * @param backgroundCompaction If storages are merged by the background worker thread
+     * instead of the appending thread. File manager of storages must be thread-safe in this case.
+     * @param storageWrapper Function which creates a list item from every merged storage.
      */
-    explicit BinaryCollapsingSortedStoragesList(IndexT batchSize, InnerRegisterSupplier innerRegisterSupplier)
-        : head_(nullptr),
-          batchSize_(batchSize),
-          innerRegisterSupplier_(std::move(innerRegisterSupplier)) {}
+    explicit BinaryCollapsingSortedStoragesList(
+        IndexT batchSize,
+        InnerRegisterSupplier innerRegisterSupplier,
+        bool backgroundCompaction = false,
+        StorageWrapper storageWrapper = [](SortedStorage &&storage) {
+            return std::make_unique<SortedStorage>(std::move(storage));
+        }
+    ) : runs_(std::make_shared<const Runs>()),
+        batchSize_(batchSize),
+        innerRegisterSupplier_(std::move(innerRegisterSupplier)),
+        storageWrapper_(std::move(storageWrapper)),
+        backgroundCompaction_(backgroundCompaction) {
+        if (backgroundCompaction_) {
+            worker_ = std::thread([this]() { compactInBackground(); });
+        }
+    }
+
+    BinaryCollapsingSortedStoragesList(const BinaryCollapsingSortedStoragesList &) = delete;
+    BinaryCollapsingSortedStoragesList &operator=(const BinaryCollapsingSortedStoragesList &) = delete;
 
     /**
      * @brief Add storage with the largest order to list.
+     * If compaction is done in background, may wait until the list is short enough.
      * @param storage New storage. Its rank must be 0.
+     * @throws Any exception that happened during background compaction.
      */
     void append(std::unique_ptr<SortedStorage> &&storage) override {
-        head_ = std::make_shared<ListNode>(std::move(storage), std::move(head_), batchSize_);
-        std::shared_ptr<ListNode> curNode = head_;
-        std::shared_ptr<ListNode> nextNode = curNode->next;
-        while (nextNode != nullptr) {
-            assert(curNode->getRank() <= nextNode->getRank());
-            if (curNode->getRank() < nextNode->getRank()) {
+        std::shared_ptr<SortedStorage> run = std::move(storage);
+        {
+            std::unique_lock lock(mutex_);
+            if (backgroundCompaction_) {
+                runsMerged_.wait(lock, [this]() {
+                    return compactionError_ || runs_->size() < MAX_RUNS_BEFORE_STALL;
+                });
+                if (compactionError_) {
+                    std::rethrow_exception(compactionError_);
+                }
+            }
+            auto updated = std::make_shared<Runs>();
+            updated->reserve(runs_->size() + 1);
+            updated->push_back(std::move(run));
+            updated->insert(updated->end(), runs_->begin(), runs_->end());
+            runs_ = std::move(updated);
+        }
+        if (backgroundCompaction_) {
+            workAvailable_.notify_one();
+            return;
+        }
+        while (true) {
+            std::shared_ptr<const Runs> snapshot = getSnapshot();
+            std::optional<std::size_t> mergeable = findMergeable(*snapshot);
+            if (!mergeable.has_value()) {
                 break;
             }
-            assert(curNode->valid());
-            assert(nextNode->valid());
-            SortedStorage mergedKeys(
-                std::vector<SortedStorage>{*nextNode->storage, *curNode->storage},
-                "collapse",
-                curNode->storage->getFileManager(),
-                batchSize_,
-                innerRegisterSupplier_
-            );
-            nextNode->storage->resetWith(std::move(mergedKeys));
-            head_ = nextNode;
-            curNode = nextNode;
-            nextNode = nextNode->next;
+            mergeRuns(*snapshot, mergeable.value());
         }
     }
 
@@ -112,22 +132,218 @@ class BinaryCollapsingSortedStoragesList : public SortedStoragesList<T, IndexT,
         std::function<bool(const T &, const FindPatternType &)> less,
         std::function<bool(const T &, const FindPatternType &)> equal
     ) override {
-        std::shared_ptr<ListNode> curNode = head_;
-        while (curNode != nullptr) {
-            assert(curNode->valid());
-            std::optional<T> found = curNode->storage->find(pattern, less, equal);
+        std::shared_ptr<const Runs> snapshot = getSnapshot();
+        for (const auto &run : *snapshot) {
+            std::optional<T> found = run->find(pattern, less, equal);
             if (found.has_value()) {
                 return found;
             }
-            curNode = curNode->next;
         }
         return std::nullopt;
     }
 
+    /**
+     * @brief Same as @p find, but passes already computed hash of @p pattern to every storage.
+     * @param pattern Find pattern.
+     * @param patternHash Hash of @p pattern, computed by @p hashTools::hashKey.
+     * @param less Predicate, accepts object from storage and pattern, returns if object is less then pattern.
+     * @param equal Predicate, accepts object from storage and pattern, returns if this is equals to pattern.
+     * @return @p std::nullopt iff object predicate is not fulfilled by any object in all storages,
+     * non-empty @p std::optional<T> otherwise.
+     */
+    std::optional<T> findHashed(
+        const FindPatternType &pattern,
+        const hashTools::KeyHash &patternHash,
+        std::function<bool(const T &, const FindPatternType &)> less,
+        std::function<bool(const T &, const FindPatternType &)> equal
+    ) override {
+        std::shared_ptr<const Runs> snapshot = getSnapshot();
+        for (const auto &run : *snapshot) {
+            std::optional<T> found = run->findHashed(pattern, patternHash, less, equal);
+            if (found.has_value()) {
+                return found;
+            }
+        }
+        return std::nullopt;
+    }
+
+    /**
+     * @brief Searches for all @p patterns in every storage, starting from the last added one.
+     * Every storage is searched only for patterns, which were not found in the newer storages.
+     * @param patterns Find patterns, ordered by @p less.
+     * @param patternHashes Hashes of @p patterns, computed by @p hashTools::hashKey, may be @p nullptr.
+     * @param less Predicate, accepts object from storage and pattern, returns if object is less then pattern.
+     * @param equal Predicate, accepts object from storage and pattern, returns if this is equals to pattern.
+     * @return Results of @p find for every pattern, in the same order.
+     */
+    std::vector<std::optional<T>> findAll(
+        const std::vector<FindPatternType> &patterns,
+        const std::vector<hashTools::KeyHash> *patternHashes,
+        std::function<bool(const T &, const FindPatternType &)> less,
+        std::function<bool(const T &, const FindPatternType &)> equal
+    ) override {
+        std::vector<std::optional<T>> found(patterns.size());
+        std::vector<std::size_t> missing(patterns.size());
+        std::iota(missing.begin(), missing.end(), 0);
+        std::shared_ptr<const Runs> snapshot = getSnapshot();
+        for (auto run = snapshot->begin(); run != snapshot->end() && !missing.empty(); ++run) {
+            std::vector<FindPatternType> missingPatterns;
+            std::vector<hashTools::KeyHash> missingHashes;
+            for (std::size_t i : missing) {
+                missingPatterns.push_back(patterns[i]);
+                if (patternHashes) {
+                    missingHashes.push_back((*patternHashes)[i]);
+                }
+            }
+            std::vector<std::optional<T>> runFound
+                = (*run)->findAll(missingPatterns, patternHashes ? &missingHashes : nullptr, less, equal);
+            std::vector<std::size_t> stillMissing;
+            for (std::size_t j = 0; j < missing.size(); ++j) {
+                if (runFound[j].has_value()) {
+                    found[missing[j]] = std::move(runFound[j]);
+                } else {
+                    stillMissing.push_back(missing[j]);
+                }
+            }
+            missing = std::move(stillMissing);
+        }
+        return found;
+    }
+
+    /**
+     * @return Current storages of the list, ordered from the most to the least relevant.
+     */
+    std::vector<std::shared_ptr<SortedStorage>> getStorages() override {
+        return *getSnapshot();
+    }
+
+    /**
+     * @brief Stops background compaction worker, if any. Merge in progress is finished.
+     */
+    ~BinaryCollapsingSortedStoragesList() override {
+        if (worker_.joinable()) {
+            {
+                std::lock_guard lock(mutex_);
+                stopping_ = true;
+            }
+            workAvailable_.notify_all();
+            worker_.join();
+        }
+    }
+
   private:
-    std::shared_ptr<ListNode> head_ = nullptr;
+    /**
+     * @return Rank of the @p storage.
+     */
+    IndexT getRank(const SortedStorage &storage) const {
+        IndexT size = storage.getItemsCount();
+        assert(size != 0);
+        return std::log2((size + batchSize_ - 1) / batchSize_);
+    }
+
+    /**
+     * @return Current list of storages, which is never changed.
+     */
+    std::shared_ptr<const Runs> getSnapshot() {
+        std::lock_guard lock(mutex_);
+        return runs_;
+    }
+
+    /**
+     * @return Index of the most relevant storage, which has to be merged with the next one, if any.
+     */
+    std::optional<std::size_t> findMergeable(const Runs &runs) const {
+        for (std::size_t i = 0; i + 1 < runs.size(); ++i) {
+            if (getRank(*runs[i]) >= getRank(*runs[i + 1])) {
+                return i;
+            }
+        }
+        return std::nullopt;
+    }
+
+    /**
+     * @brief Merges storages @p i and @p i + 1 of @p runs and replaces them with the result in the actual list.
+     * Must be called without @p mutex_ held.
+     */
+    void mergeRuns(const Runs &runs, std::size_t i) {
+        const std::shared_ptr<SortedStorage> &newer = runs[i];
+        const std::shared_ptr<SortedStorage> &older = runs[i + 1];
+        std::shared_ptr<SortedStorage> merged = storageWrapper_(SortedStorage(
+            std::vector<SortedStorage>{*older, *newer},
+            "collapse-" + getProcessTag() + "-" + std::to_string(collapsesCount_++),
+            newer->getFileManager(),
+            batchSize_,
+            innerRegisterSupplier_
+        ));
+        {
+            std::lock_guard lock(mutex_);
+            auto updated = std::make_shared<Runs>();
+            updated->reserve(runs_->size() - 1);
+            for (auto it = runs_->begin(); it != runs_->end(); ++it) {
+                if (*it == newer) {
+                    assert(std::next(it) != runs_->end() && *std::next(it) == older);
+                    updated->push_back(merged);
+                    ++it;
+                } else {
+                    updated->push_back(*it);
+                }
+            }
+            runs_ = std::move(updated);
+        }
+        runsMerged_.notify_all();
+    }
+
+    /**
+     * @brief Background compaction worker routine. Merges storages while there is
+     * something to merge, then sleeps until new storage is appended.
+     */
+    void compactInBackground() {
+        std::unique_lock lock(mutex_);
+        while (true) {
+            std::optional<std::size_t> mergeable;
+            workAvailable_.wait(lock, [&]() {
+                return stopping_ || (mergeable = findMergeable(*runs_)).has_value();
+            });
+            if (stopping_) {
+                return;
+            }
+            std::shared_ptr<const Runs> snapshot = runs_;
+            lock.unlock();
+            try {
+                mergeRuns(*snapshot, mergeable.value());
+            } catch (...) {
+                lock.lock();
+                compactionError_ = std::current_exception();
+                lock.unlock();
+                runsMerged_.notify_all();
+                return;
+            }
+            lock.lock();
+        }
+    }
+
+    /**
+     * @return Random tag of this process, which distinguishes merged storages files
+     * from the files left by other processes in the same folder.
+     */
+    static const std::string &getProcessTag() {
+        static const std::string tag = std::to_string(std::random_device{}());
+        return tag;
+    }
+
+    static inline std::atomic<std::uint64_t> collapsesCount_ = 0;
+
+    std::shared_ptr<const Runs> runs_;
     IndexT batchSize_;
     InnerRegisterSupplier innerRegisterSupplier_;
+    StorageWrapper storageWrapper_;
+    const bool backgroundCompaction_;
+    std::mutex mutex_;
+    std::condition_variable workAvailable_;
+    std::condition_variable runsMerged_;
+    bool stopping_ = false;
+    std::exception_ptr compactionError_;
+    std::thread worker_;
 };
 
 } // supermap
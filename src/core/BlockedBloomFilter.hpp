@@ -0,0 +1,249 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cmath>
+#include <random>
+
+#include "Filter.hpp"
+#include "io/SerializeHelper.hpp"
+#include "io/ShallowSerializer.hpp"
+#include "exception/IllegalStateException.hpp"
+#include "exception/IllegalArgumentException.hpp"
+#include "hasher/XXHasher.hpp"
+#include "hasher/HashTools.hpp"
+
+namespace supermap {
+
+/**
+ * @brief A bloom filter, which keeps all bits of every element in a single cache line sized block.
+ * Element is hashed once: the block is chosen by the upper half of the hash, and the bits
+ * inside the block are derived from the lower half by repeated multiplicative hashing. Thus, every check
+ * touches exactly one cache line, and is done with a branch-free comparison of the whole block.
+ * False positive rate is at most twice the requested error probability,
+ * if it is not less than 1/1024, and close to it for larger probabilities.
+ * @tparam T Type of elements.
+ */
+template <typename T>
+class BlockedBloomFilter : public Filter<T> {
+  private:
+    using BaseFilter = Filter<T>;
+
+    static constexpr std::size_t WORD_BITS = 64;
+    static constexpr std::size_t BLOCK_WORDS = 8;
+    static constexpr std::size_t BLOCK_BITS = WORD_BITS * BLOCK_WORDS;
+    static constexpr std::size_t BLOCK_BITS_LOG = 9;
+    static constexpr std::uint32_t PROBE_MULTIPLIER = 0x9E3779B9;
+
+    /**
+     * @brief Part of the filter, which occupies exactly one cache line.
+     */
+    struct alignas(BLOCK_BITS / 8) Block {
+        std::array<std::uint64_t, BLOCK_WORDS> words{};
+    };
+
+  public:
+    /**
+     * @brief The largest number of bits, which are set for every element.
+     */
+    static constexpr std::size_t MAX_HASH_FUNCTIONS = 16;
+
+    /**
+     * @param errorProbability Desired false positive probability.
+     * @param hasher Hasher of serialized elements.
+     * @param seed Seed, which is mixed into the element hashes.
+     * @throws IllegalArgumentException if @p errorProbability is not in (0, 1].
+     */
+    explicit BlockedBloomFilter(double errorProbability,
+                                std::unique_ptr<Hasher> &&hasher,
+                                std::uint64_t seed = std::random_device{}())
+        : hasher_(std::move(hasher)), seed_(seed) {
+        if (errorProbability <= 0 || errorProbability > 1) {
+            throw supermap::IllegalArgumentException("Error probability must be a positive number not bigger than 1");
+        }
+        bitsPerElement_ = std::max(1.0, -1.44 * std::log2(errorProbability));
+        hashFunctions_ = std::clamp<std::size_t>(
+            static_cast<std::size_t>(std::round(std::log(2.0) * bitsPerElement_)),
+            1,
+            MAX_HASH_FUNCTIONS
+        );
+    }
+
+    /**
+     * @param bitsPerElement Number of filter bits per reserved element.
+     * @param hasher Hasher of serialized elements.
+     * @param seed Seed, which is mixed into the element hashes.
+     * @return Filter with @p bitsPerElement bits per element.
+     * @throws IllegalArgumentException if @p bitsPerElement is less than 1.
+     */
+    static BlockedBloomFilter withBitsPerElement(double bitsPerElement,
+                                                 std::unique_ptr<Hasher> &&hasher,
+                                                 std::uint64_t seed = std::random_device{}()) {
+        if (!(bitsPerElement >= 1)) {
+            throw supermap::IllegalArgumentException("Bits per element must be at least 1");
+        }
+        return BlockedBloomFilter(std::pow(2.0, -bitsPerElement / 1.44), std::move(hasher), seed);
+    }
+
+    BlockedBloomFilter(const BlockedBloomFilter &other)
+        : hasher_(other.hasher_->clone()),
+          bitsPerElement_(other.bitsPerElement_),
+          hashFunctions_(other.hashFunctions_),
+          seed_(other.seed_),
+          blocks_(other.blocks_),
+          wasReserved_(other.wasReserved_) {
+    }
+
+    /**
+     * @brief Add an element to filter.
+     * @param value Element to add.
+     * @throws IllegalStateException if filter size was not reserved or was set to zero.
+     */
+    void add(const T &value) override {
+        checkReserved();
+        std::uint64_t hash = getHash(value);
+        Block mask = getMask(hash);
+        Block &block = blocks_[getBlockIndex(hash)];
+        for (std::size_t i = 0; i < BLOCK_WORDS; ++i) {
+            block.words[i] |= mask.words[i];
+        }
+    }
+
+    /**
+     * @return @p false if @p value was never added to filter, anything otherwise.
+     * @throws IllegalStateException if filter size was not reserved or was set to zero.
+     */
+    bool mightContain(const T &value) const override {
+        return mightContainHashed(value, hashTools::hashKey(*hasher_, value));
+    }
+
+    /**
+     * @return @p false if @p value was never added to filter, anything otherwise.
+     * @p valueHash is used, if it was computed by the hasher of this filter.
+     * @throws IllegalStateException if filter size was not reserved or was set to zero.
+     */
+    bool mightContainHashed(const T &value, const hashTools::KeyHash &valueHash) const override {
+        checkReserved();
+        std::uint64_t hash = hashTools::mix(
+            valueHash.isComputedBy(*hasher_) ? valueHash.value : hashTools::hashKey(*hasher_, value).value,
+            seed_
+        );
+        Block mask = getMask(hash);
+        const Block &block = blocks_[getBlockIndex(hash)];
+        std::uint64_t missing = 0;
+        for (std::size_t i = 0; i < BLOCK_WORDS; ++i) {
+            missing |= mask.words[i] & ~block.words[i];
+        }
+        return missing == 0;
+    }
+
+    /**
+     * @brief Create cloned version of this filter.
+     */
+    std::unique_ptr<BaseFilter> clone() const override {
+        return std::make_unique<BlockedBloomFilter<T>>(*this);
+    }
+
+    /**
+     * @brief Reserve filter for @p numberOfElements elements.
+     * @throws IllegalStateException if filter has been already reserved.
+     */
+    void reserve(std::uint64_t numberOfElements) override {
+        if (wasReserved_) {
+            throw supermap::IllegalStateException("Filter size has been already reserved");
+        }
+        wasReserved_ = true;
+        auto bits = static_cast<std::size_t>(std::ceil(static_cast<double>(numberOfElements) * bitsPerElement_));
+        blocks_.resize((bits + BLOCK_BITS - 1) / BLOCK_BITS);
+    }
+
+    [[nodiscard]] std::uint64_t getMemoryBits() const override {
+        return blocks_.size() * BLOCK_BITS;
+    }
+
+    /**
+     * @return Estimated false positive probability, which is the average of (s / b)^k over all blocks,
+     * where @p s of @p b block bits are set, and @p k is the number of hash functions.
+     */
+    [[nodiscard]] double getFalsePositiveProbability() const override {
+        if (blocks_.empty()) {
+            return 1;
+        }
+        double sum = 0;
+        for (const Block &block : blocks_) {
+            std::size_t setBits = 0;
+            for (std::uint64_t word : block.words) {
+                setBits += std::bitset<WORD_BITS>(word).count();
+            }
+            sum += std::pow(static_cast<double>(setBits) / BLOCK_BITS, static_cast<double>(hashFunctions_));
+        }
+        return sum / static_cast<double>(blocks_.size());
+    }
+
+    /**
+     * @brief Writes hash parameters and filter blocks to @p os.
+     * @param os Output stream.
+     */
+    void save(std::ostream &os) const override {
+        io::serialize<std::uint64_t>(hashFunctions_, os);
+        io::serialize<std::uint64_t>(seed_, os);
+        io::serialize<std::uint64_t>(blocks_.size(), os);
+        os.write(reinterpret_cast<const char *>(blocks_.data()),
+                 static_cast<std::streamsize>(blocks_.size() * sizeof(Block)));
+    }
+
+    /**
+     * @brief Reads hash parameters and filter blocks, written by @p save, from @p is.
+     * @param is Input stream.
+     */
+    void restore(std::istream &is) override {
+        hashFunctions_ = io::deserialize<std::uint64_t>(is);
+        seed_ = io::deserialize<std::uint64_t>(is);
+        blocks_.assign(io::deserialize<std::uint64_t>(is), Block{});
+        is.read(reinterpret_cast<char *>(blocks_.data()),
+                static_cast<std::streamsize>(blocks_.size() * sizeof(Block)));
+        if (!is.good() || hashFunctions_ == 0 || hashFunctions_ > MAX_HASH_FUNCTIONS) {
+            throw IOException("Unable to restore blocked bloom filter");
+        }
+        wasReserved_ = true;
+    }
+
+  private:
+    void checkReserved() const {
+        if (blocks_.empty()) {
+            throw supermap::IllegalStateException("Filter size was not reserved or was set to zero");
+        }
+    }
+
+    std::uint64_t getHash(const T &value) const {
+        return hashTools::mix(hashTools::hashKey(*hasher_, value).value, seed_);
+    }
+
+    std::size_t getBlockIndex(std::uint64_t hash) const {
+        return static_cast<std::size_t>(((hash >> 32) * blocks_.size()) >> 32);
+    }
+
+    /**
+     * @return Block with bits of element with hash @p hash set.
+     */
+    Block getMask(std::uint64_t hash) const {
+        Block mask;
+        auto probe = static_cast<std::uint32_t>(hash);
+        for (std::size_t i = 0; i < hashFunctions_; ++i) {
+            std::uint32_t bit = probe >> (32 - BLOCK_BITS_LOG);
+            mask.words[bit / WORD_BITS] |= std::uint64_t{1} << (bit % WORD_BITS);
+            probe *= PROBE_MULTIPLIER;
+        }
+        return mask;
+    }
+
+    std::unique_ptr<Hasher> hasher_;
+    double bitsPerElement_;
+    std::size_t hashFunctions_;
+    std::uint64_t seed_;
+    std::vector<Block> blocks_;
+    bool wasReserved_ = false;
+};
+
+} // supermap
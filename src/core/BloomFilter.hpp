@@ -1,19 +1,25 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
 #include <random>
-#include <sstream>
 
 #include "Filter.hpp"
 #include "primitive/KeyValue.hpp"
+#include "io/ShallowSerializer.hpp"
 #include "exception/IllegalStateException.hpp"
 #include "exception/IllegalArgumentException.hpp"
 #include "xxhash.h"
 #include "hasher/XXHasher.hpp"
+#include "hasher/HashTools.hpp"
 
 namespace supermap {
 
 /**
  * @brief A filter based on the bloom filtering algorithm.
+ * Filter of m bits, reserved for n elements, uses k = ln(2) * m / n hash functions,
+ * which minimizes false positive probability.
+ * Element is hashed once, and all k bit positions are derived from this hash and the seeds of hash functions.
  */
 template <typename T>
 class BloomFilter : public Filter<T> {
@@ -21,19 +27,43 @@ class BloomFilter : public Filter<T> {
     using BaseFilter = Filter<T>;
 
   public:
-    explicit BloomFilter(double errorProbability, std::unique_ptr<Hasher> &&hasher) : hasher_(std::move(hasher)) {
+    /**
+     * @brief The largest number of hash functions.
+     */
+    static constexpr std::size_t MAX_HASH_FUNCTIONS = 32;
+
+    /**
+     * @param errorProbability Desired false positive probability, which determines the number of bits per element.
+     * @param hasher Hasher of serialized elements.
+     * @param seed Seed of the generator of hash functions seeds.
+     * @throws IllegalArgumentException if @p errorProbability is not in (0, 1].
+     */
+    explicit BloomFilter(double errorProbability,
+                         std::unique_ptr<Hasher> &&hasher,
+                         std::uint64_t seed = std::random_device{}())
+        : hasher_(std::move(hasher)), seed_(seed) {
         if (errorProbability <= 0 || errorProbability > 1) {
             throw supermap::IllegalArgumentException("Error probability must be a positive number not bigger than 1");
         }
         sizeMultiplier_ = std::max(1.0, -1.44 * std::log2(errorProbability));
-        constexpr std::size_t keysSize = io::FixedDeserializedSizeRegister<T>::exactDeserializedSize;
-        auto numberOfHashFunctions = std::max(1ul, static_cast<std::size_t>(std::ceil(std::log2(keysSize))));
-        seeds_.resize(numberOfHashFunctions);
-        std::mt19937_64 rnd(std::random_device{}());
-        for (auto &seed : seeds_) {
-            seed = rnd();
+    }
+
+    /**
+     * @param bitsPerElement Number of filter bits per reserved element.
+     * @param hasher Hasher of serialized elements.
+     * @param seed Seed of the generator of hash functions seeds.
+     * @return Filter, which false positive probability is about 0.6185^bitsPerElement.
+     * @throws IllegalArgumentException if @p bitsPerElement is less than 1.
+     */
+    static BloomFilter withBitsPerElement(double bitsPerElement,
+                                          std::unique_ptr<Hasher> &&hasher,
+                                          std::uint64_t seed = std::random_device{}()) {
+        if (!(bitsPerElement >= 1)) {
+            throw supermap::IllegalArgumentException("Bits per element must be at least 1");
         }
+        return BloomFilter(std::pow(2.0, -bitsPerElement / 1.44), std::move(hasher), seed);
     }
+
     /**
      * @brief Add an key-index pair to filter.
      * @param keyIndex Pair to add to filter.
@@ -42,10 +72,9 @@ class BloomFilter : public Filter<T> {
         if (elements_.empty()) {
             throw supermap::IllegalStateException("Filter size was not reserved or was set to zero");
         }
-        std::string data = serialize(value);
+        std::uint64_t hash = hashTools::hashKey(*hasher_, value).value;
         for (auto &seed : seeds_) {
-            std::uint64_t index = getHashWithSeed(data, seed);
-            elements_[index] = true;
+            elements_[getIndex(hash, seed)] = true;
         }
     }
 
@@ -53,13 +82,22 @@ class BloomFilter : public Filter<T> {
      * @return @p false if @p was never added to filter, anything otherwise.
      */
     bool mightContain(const T &value) const override {
+        return mightContainHashed(value, hashTools::hashKey(*hasher_, value));
+    }
+
+    /**
+     * @return @p false if @p was never added to filter, anything otherwise.
+     * @p valueHash is used, if it was computed by the hasher of this filter.
+     */
+    bool mightContainHashed(const T &value, const hashTools::KeyHash &valueHash) const override {
         if (elements_.empty()) {
             throw supermap::IllegalStateException("Filter size was not reserved or was set to zero");
         }
-        std::string data = serialize(value);
+        std::uint64_t hash = valueHash.isComputedBy(*hasher_)
+                             ? valueHash.value
+                             : hashTools::hashKey(*hasher_, value).value;
         for (auto &seed : seeds_) {
-            std::uint64_t index = getHashWithSeed(data, seed);
-            if (!elements_[index]) {
+            if (!elements_[getIndex(hash, seed)]) {
                 return false;
             }
         }
@@ -80,11 +118,89 @@ class BloomFilter : public Filter<T> {
         wasReserved_ = true;
         auto size = static_cast<std::size_t>(std::ceil(static_cast<double>(numberOfElements) * sizeMultiplier_));
         elements_.resize(size);
+        if (numberOfElements == 0) {
+            return;
+        }
+        double bitsPerElement = static_cast<double>(size) / static_cast<double>(numberOfElements);
+        seeds_.resize(std::clamp<std::size_t>(
+            static_cast<std::size_t>(std::round(std::log(2.0) * bitsPerElement)),
+            1,
+            MAX_HASH_FUNCTIONS
+        ));
+        std::mt19937_64 rnd(seed_);
+        for (auto &seed : seeds_) {
+            seed = rnd();
+        }
     };
 
+    /**
+     * @return Number of hash functions, which is chosen as ln(2) * m / n on reservation
+     * of m bits for n elements.
+     */
+    [[nodiscard]] std::size_t getHashFunctionsCount() const noexcept {
+        return seeds_.size();
+    }
+
+    [[nodiscard]] std::uint64_t getMemoryBits() const override {
+        return elements_.size();
+    }
+
+    /**
+     * @return Estimated false positive probability, which is (s / m)^k,
+     * where @p s of @p m filter bits are set, and @p k is the number of hash functions.
+     */
+    [[nodiscard]] double getFalsePositiveProbability() const override {
+        if (elements_.empty()) {
+            return 1;
+        }
+        auto setBits = static_cast<double>(std::count(elements_.begin(), elements_.end(), true));
+        return std::pow(setBits / static_cast<double>(elements_.size()), static_cast<double>(seeds_.size()));
+    }
+
+    /**
+     * @brief Writes hash seeds and filter bits to @p os.
+     * @param os Output stream.
+     */
+    void save(std::ostream &os) const override {
+        io::serialize<std::uint64_t>(seeds_.size(), os);
+        for (auto seed : seeds_) {
+            io::serialize<std::uint64_t>(seed, os);
+        }
+        io::serialize<std::uint64_t>(elements_.size(), os);
+        std::vector<char> bits((elements_.size() + 7) / 8, 0);
+        for (std::size_t i = 0; i < elements_.size(); ++i) {
+            if (elements_[i]) {
+                bits[i / 8] = static_cast<char>(bits[i / 8] | (1 << (i % 8)));
+            }
+        }
+        os.write(bits.data(), static_cast<std::streamsize>(bits.size()));
+    }
+
+    /**
+     * @brief Reads hash seeds and filter bits, written by @p save, from @p is.
+     * @param is Input stream.
+     */
+    void restore(std::istream &is) override {
+        seeds_.resize(io::deserialize<std::uint64_t>(is));
+        for (auto &seed : seeds_) {
+            seed = io::deserialize<std::uint64_t>(is);
+        }
+        elements_.assign(io::deserialize<std::uint64_t>(is), false);
+        std::vector<char> bits((elements_.size() + 7) / 8);
+        is.read(bits.data(), static_cast<std::streamsize>(bits.size()));
+        if (!is.good()) {
+            throw IOException("Unable to restore bloom filter");
+        }
+        for (std::size_t i = 0; i < elements_.size(); ++i) {
+            elements_[i] = (bits[i / 8] >> (i % 8)) & 1;
+        }
+        wasReserved_ = true;
+    }
+
     BloomFilter(const BloomFilter &other)
         : hasher_(other.hasher_->clone()),
           sizeMultiplier_(other.sizeMultiplier_),
+          seed_(other.seed_),
           seeds_(other.seeds_),
           elements_(other.elements_),
           wasReserved_(other.wasReserved_) {
@@ -93,18 +209,13 @@ class BloomFilter : public Filter<T> {
   private:
     std::unique_ptr<Hasher> hasher_;
     double sizeMultiplier_;
+    std::uint64_t seed_;
     std::vector<XXH64_hash_t> seeds_;
     std::vector<bool> elements_;
     bool wasReserved_ = false;
 
-    std::uint64_t getHashWithSeed(const std::string &string, XXH64_hash_t seed) const {
-        return hasher_->hash(string, seed) % elements_.size();
-    }
-
-    std::string serialize(const T &value) const {
-        std::stringstream stream;
-        io::serialize(value, stream);
-        return stream.str();
+    std::uint64_t getIndex(std::uint64_t hash, XXH64_hash_t seed) const {
+        return hashTools::mix(hash, seed) % elements_.size();
     }
 };
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <functional>
+
 #include "StorageItemRegister.hpp"
 
 namespace supermap {
@@ -77,6 +79,15 @@ class CountingStorageItemRegister
     explicit CountingStorageItemRegister(InnerRegisterSupplier innerStorageSupplier)
         : innerRegister_(innerStorageSupplier()) {}
 
+    /**
+     * @brief Creates register, which has already registered @p count items.
+     * @param count Number of registered items.
+     * @param innerRegister Inner register, which has already registered the same items.
+     */
+    explicit CountingStorageItemRegister(IndexT count,
+                                         std::unique_ptr<StorageItemRegister<T, AdditionalInfo>> &&innerRegister)
+        : count_(count), innerRegister_(std::move(innerRegister)) {}
+
     CountingStorageItemRegister(const CountingStorageItemRegister &other)
         : count_(other.count_),
           innerRegister_(other.innerRegister_->clone()) {}
@@ -127,11 +138,14 @@ class CountingStorageItemRegister
         innerRegister_->reserve(n);
     }
 
-  private:
-    explicit CountingStorageItemRegister(IndexT count,
-                                         std::unique_ptr<StorageItemRegister<T, AdditionalInfo>> &&innerRegister)
-        : count_(count), innerRegister_(std::move(innerRegister)) {}
+    /**
+     * @brief Seals inner register.
+     */
+    void seal() override {
+        innerRegister_->seal();
+    }
 
+  private:
     IndexT count_ = 0;
     std::unique_ptr<StorageItemRegister<T, AdditionalInfo>> innerRegister_;
 };
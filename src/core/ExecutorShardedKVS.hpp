@@ -0,0 +1,169 @@
+#pragma once
+
+#include <future>
+#include <thread>
+
+#include "core/KeyValueStorage.hpp"
+#include "core/ShardWorker.hpp"
+#include "hasher/HashTools.hpp"
+
+namespace supermap {
+
+/**
+ * @brief A key-value storage, which assigns keys to N smaller key-value storages as shards by key hash,
+ * like @p KeyHashingShardedKVS does, but every shard is owned by its own worker thread, which may be pinned
+ * to a CPU core. Requests are queued to the worker of their shard without locks, so shards do not need to be
+ * thread-safe, and each shard stays in the cache of one core. All methods are thread-safe, asynchronous ones
+ * return futures, synchronous ones wait for them. Requests of one thread to one key are executed in order.
+ * @tparam Key type of key.
+ * @tparam Value type of value.
+ * @tparam IndexT type of storage size.
+ */
+template <
+    typename Key,
+    typename Value,
+    typename IndexT
+>
+class ExecutorShardedKVS : public KeyValueStorage<Key, Value, IndexT> {
+  private:
+    using KVS = KeyValueStorage<Key, Value, IndexT>;
+    using Worker = ShardWorker<Key, Value, IndexT>;
+
+  public:
+    /**
+     * @param nestedStorages Shards.
+     * @param hasher Hasher of keys.
+     * @param pinWorkers If worker of shard @p i should be pinned to the core @p i modulo the number of cores.
+     */
+    ExecutorShardedKVS(
+        std::vector<std::unique_ptr<KVS>> &&nestedStorages,
+        std::unique_ptr<Hasher> &&hasher,
+        bool pinWorkers
+    ) : hasher_(std::move(hasher)) {
+        const std::size_t cores = std::thread::hardware_concurrency();
+        workers_.reserve(nestedStorages.size());
+        for (std::size_t i = 0; i < nestedStorages.size(); ++i) {
+            std::optional<std::size_t> core;
+            if (pinWorkers && cores > 0) {
+                core = i % cores;
+            }
+            workers_.push_back(std::make_unique<Worker>(std::move(nestedStorages[i]), core));
+        }
+    }
+
+    /**
+     * @brief Queues adding of @p value by @p key.
+     * @return Future, which is ready when the value is added.
+     */
+    std::future<void> addAsync(const Key &key, Value &&value) {
+        return getWorker(hashTools::hashKey(*hasher_, key)).submit(
+            [key, value = std::move(value)](KVS &storage) mutable {
+                storage.add(key, std::move(value));
+            });
+    }
+
+    /**
+     * @brief Queues reading of value associated with @p key.
+     * @return Future of the value, as it would be returned by @p getValue.
+     */
+    std::future<std::optional<Value>> getValueAsync(const Key &key) {
+        return getValueAsync(key, hashTools::hashKey(*hasher_, key));
+    }
+
+    void add(const Key &key, Value &&value) override {
+        addAsync(key, std::move(value)).get();
+    }
+
+    void remove(const Key &key) override {
+        getWorker(hashTools::hashKey(*hasher_, key)).submit([key](KVS &storage) {
+            storage.remove(key);
+        }).get();
+    }
+
+    std::optional<Value> getValue(const Key &key) override {
+        return getValueAsync(key).get();
+    }
+
+    std::optional<Value> getValueHashed(const Key &key, const hashTools::KeyHash &keyHash) override {
+        if (!keyHash.isComputedBy(*hasher_)) {
+            return getValue(key);
+        }
+        return getValueAsync(key, keyHash).get();
+    }
+
+    /**
+     * @brief Splits @p keys by shards and queues one @p multiGetHashed to each of their workers,
+     * so that shards are read in parallel.
+     */
+    std::vector<std::optional<Value>> multiGet(const std::vector<Key> &keys) override {
+        std::vector<std::vector<std::size_t>> positions(workers_.size());
+        std::vector<std::vector<Key>> shardKeys(workers_.size());
+        std::vector<std::vector<hashTools::KeyHash>> shardHashes(workers_.size());
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            hashTools::KeyHash keyHash = hashTools::hashKey(*hasher_, keys[i]);
+            std::size_t shardId = getShardId(keyHash);
+            positions[shardId].push_back(i);
+            shardKeys[shardId].push_back(keys[i]);
+            shardHashes[shardId].push_back(keyHash);
+        }
+        std::vector<std::future<std::vector<std::optional<Value>>>> shardValues(workers_.size());
+        for (std::size_t shardId = 0; shardId < workers_.size(); ++shardId) {
+            if (!positions[shardId].empty()) {
+                shardValues[shardId] = workers_[shardId]->submit(
+                    [batchKeys = std::move(shardKeys[shardId]),
+                     batchHashes = std::move(shardHashes[shardId])](KVS &storage) {
+                        return storage.multiGetHashed(batchKeys, batchHashes);
+                    });
+            }
+        }
+        std::vector<std::optional<Value>> values(keys.size());
+        for (std::size_t shardId = 0; shardId < workers_.size(); ++shardId) {
+            if (positions[shardId].empty()) {
+                continue;
+            }
+            std::vector<std::optional<Value>> found = shardValues[shardId].get();
+            for (std::size_t j = 0; j < found.size(); ++j) {
+                values[positions[shardId][j]] = std::move(found[j]);
+            }
+        }
+        return values;
+    }
+
+    IndexT getUpperSizeBound() const override {
+        std::vector<std::future<IndexT>> sizes;
+        sizes.reserve(workers_.size());
+        for (const auto &worker : workers_) {
+            sizes.push_back(worker->submit([](KVS &storage) { return storage.getUpperSizeBound(); }));
+        }
+        IndexT size = 0;
+        for (auto &shardSize : sizes) {
+            size += shardSize.get();
+        }
+        return size;
+    }
+
+  private:
+    std::future<std::optional<Value>> getValueAsync(const Key &key, const hashTools::KeyHash &keyHash) {
+        return getWorker(keyHash).submit([key, keyHash](KVS &storage) {
+            return storage.getValueHashed(key, keyHash);
+        });
+    }
+
+    Worker &getWorker(const hashTools::KeyHash &keyHash) {
+        return *workers_[getShardId(keyHash)];
+    }
+
+    std::size_t getShardId(const hashTools::KeyHash &keyHash) const {
+        return keyHash.value % workers_.size();
+    }
+
+    std::unique_ptr<Hasher> hasher_;
+
+    /**
+     * @brief Workers are declared after the hasher, so that they finish queued requests,
+     * which refer to the hasher, before it is destroyed.
+     */
+    std::vector<std::unique_ptr<Worker>> workers_;
+};
+
+} // namespace supermap
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <vector>
 
 #include "KeyValueStorage.hpp"
@@ -25,6 +26,28 @@ class ExtractibleKeyValueStorage
      * inner storage, such that the @p getUpperSizeBound will return 0.
      */
     virtual std::vector<KeyValue<Key, Value>> extract() && = 0;
+
+    /**
+     * @brief Passes all inner key-value pairs to @p consumer in ascending key order, emptying
+     * inner storage, such that the @p getUpperSizeBound will return 0.
+     * By default pairs are extracted to the vector with @p extract first.
+     * @param consumer Function which accepts every key-value pair.
+     */
+    virtual void extractSorted(const std::function<void(const KeyValue<Key, Value> &)> &consumer) && {
+        for (const auto &kv : std::move(*this).extract()) {
+            consumer(kv);
+        }
+    }
+
+    /**
+     * @brief Passes all inner key-value pairs to @p consumer in ascending key order, leaving storage unchanged.
+     * May be called concurrently with @p getValue, but not with modifications.
+     * @param consumer Function which accepts every key-value pair.
+     * @throws NotImplementedException if storage can not be walked without extraction.
+     */
+    virtual void forEachSorted(const std::function<void(const KeyValue<Key, Value> &)> &) const {
+        throw NotImplementedException("Walk over the extractible key-value storage");
+    }
 };
 
 } // supermap
@@ -1,7 +1,11 @@
 #pragma once
 
 #include "Cloneable.hpp"
+#include "exception/SupermapException.hpp"
+#include "hasher/HashTools.hpp"
 
+#include <istream>
+#include <ostream>
 #include <string>
 
 namespace supermap {
@@ -29,10 +33,55 @@ class Filter : public Cloneable<Filter<T>> {
      */
     [[nodiscard]] virtual bool mightContain(const T &elem) const = 0;
 
+    /**
+     * @brief Same as @p mightContain, but may use already computed hash of @p elem instead of hashing it again.
+     * @param elem An element to check.
+     * @param elemHash Hash of @p elem, computed by @p hashTools::hashKey.
+     * @return if @p false, then @p elem was never added to filter.
+     */
+    [[nodiscard]] virtual bool mightContainHashed(const T &elem, const hashTools::KeyHash &) const {
+        return mightContain(elem);
+    }
+
     /**
      * @brief Reserve filter for @p n elements.
      */
     virtual void reserve(std::uint64_t) {};
+
+    /**
+     * @brief Tells filter that no more elements will be added, so it can be finalized.
+     */
+    virtual void seal() {}
+
+    /**
+     * @return Number of bits of memory, occupied by the filter state.
+     */
+    [[nodiscard]] virtual std::uint64_t getMemoryBits() const {
+        return 0;
+    }
+
+    /**
+     * @return Estimated probability that @p mightContain returns @p true for an element, which was not added.
+     */
+    [[nodiscard]] virtual double getFalsePositiveProbability() const {
+        return 1;
+    }
+
+    /**
+     * @brief Writes filter state to @p os, so that it can be restored with @p restore.
+     * @throws NotImplementedException if filter state can not be saved.
+     */
+    virtual void save(std::ostream &) const {
+        throw NotImplementedException("Filter saving");
+    }
+
+    /**
+     * @brief Replaces filter state with the one written by @p save of a filter of the same type.
+     * @throws NotImplementedException if filter state can not be restored.
+     */
+    virtual void restore(std::istream &) {
+        throw NotImplementedException("Filter restoring");
+    }
 };
 
 } // supermap
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+namespace supermap {
+
+/**
+ * @brief Tells how many filter bits per key are given to the index storage of the given size.
+ */
+class FilterPolicy {
+  public:
+    /**
+     * @param items Number of keys in the index storage.
+     * @return Number of filter bits per key. If it is less than 1, storage should not be filtered at all.
+     */
+    [[nodiscard]] virtual double getBitsPerKey(std::uint64_t items) const = 0;
+
+    /**
+     * @brief Tells the policy how many keys there are in all index storages together.
+     * @param items Total number of keys.
+     */
+    virtual void setTotalItems(std::uint64_t) {}
+
+    virtual ~FilterPolicy() = default;
+};
+
+/**
+ * @brief Policy, which gives the same number of bits per key to all storages.
+ */
+class UniformFilterPolicy : public FilterPolicy {
+  public:
+    /**
+     * @param bitsPerKey Number of bits per key of every storage.
+     */
+    explicit UniformFilterPolicy(double bitsPerKey) : bitsPerKey_(bitsPerKey) {}
+
+    [[nodiscard]] double getBitsPerKey(std::uint64_t) const override {
+        return bitsPerKey_;
+    }
+
+  private:
+    const double bitsPerKey_;
+};
+
+/**
+ * @brief Policy, which distributes the filter memory budget among storages so that the sum of their
+ * false positive probabilities, which is the expected number of excess disk reads per lookup, is minimal.
+ * It is reached when the false positive probability of every storage is proportional to its size:
+ * small recently added storages get more bits per key, and the largest ones get less, or none at all,
+ * if the budget is small. Storages are assumed to form a geometric sequence with ratio 2,
+ * like in @p BinaryCollapsingSortedStoragesList, where a storage of n keys out of N gets
+ * the false positive probability 4 * exp(-B * ln(2)^2) * n / N, where B is the average number of bits per key.
+ */
+class MonkeyFilterPolicy : public FilterPolicy {
+  public:
+    /**
+     * @param bitsPerKey Average number of bits per key of all storages.
+     */
+    explicit MonkeyFilterPolicy(double bitsPerKey)
+        : falsePositivesPerLookup_(4 * std::exp(-bitsPerKey * LN2_SQUARED)) {}
+
+    /**
+     * @param items Number of keys in the index storage.
+     * @return Number of bits per key, which gives the storage its optimal false positive probability.
+     */
+    [[nodiscard]] double getBitsPerKey(std::uint64_t items) const override {
+        if (items == 0) {
+            return 0;
+        }
+        std::uint64_t total = std::max<std::uint64_t>(totalItems_.load(std::memory_order_relaxed), items);
+        double falsePositiveProbability
+            = falsePositivesPerLookup_ * static_cast<double>(items) / static_cast<double>(total);
+        if (falsePositiveProbability >= 1) {
+            return 0;
+        }
+        return -std::log(falsePositiveProbability) / LN2_SQUARED;
+    }
+
+    void setTotalItems(std::uint64_t items) override {
+        totalItems_.store(items, std::memory_order_relaxed);
+    }
+
+  private:
+    static constexpr double LN2_SQUARED = 0.4804530139182014;
+
+    const double falsePositivesPerLookup_;
+    std::atomic<std::uint64_t> totalItems_ = 0;
+};
+
+} // supermap
@@ -70,6 +70,65 @@ class FilteredStorage : public SortedSingleFileIndexedStorage<Content, IndexT, R
         }
         return SortedStorage::find(pattern, std::move(less), std::move(equal));
     }
+
+    /**
+     * @brief Same as @p find, but checks the filter with already computed hash of @p pattern.
+     * @param pattern Find pattern
+     * @param patternHash Hash of @p pattern, computed by @p hashTools::hashKey.
+     * @param less Predicate, accepts object from storage and pattern, returns if object is less then pattern.
+     * @param equal Predicate, accepts object from storage and pattern, returns if this is equals to pattern.
+     * @return @p std::nullopt iff object predicate is not fulfilled by any object in all storages,
+     * non-empty @p std::optional<T> otherwise.
+     */
+    std::optional<Content> findHashed(
+        const FindPattern &pattern,
+        const hashTools::KeyHash &patternHash,
+        std::function<bool(const Content &, const FindPattern &)> less,
+        std::function<bool(const Content &, const FindPattern &)> equal
+    ) override {
+        std::shared_ptr<FilterBase> filter = this->getRegisterInfo().additional;
+        if (!filter->mightContainHashed(pattern, patternHash)) {
+            return std::nullopt;
+        }
+        return SortedStorage::find(pattern, std::move(less), std::move(equal));
+    }
+
+    /**
+     * @brief Checks all @p patterns by the filter first, and then searches for the rest of them at once.
+     * @param patterns Find patterns, ordered by @p less.
+     * @param patternHashes Hashes of @p patterns, computed by @p hashTools::hashKey, may be @p nullptr.
+     * @param less Predicate, accepts object from storage and pattern, returns if object is less then pattern.
+     * @param equal Predicate, accepts object from storage and pattern, returns if this is equals to pattern.
+     * @return Results of @p find for every pattern, in the same order.
+     */
+    std::vector<std::optional<Content>> findAll(
+        const std::vector<FindPattern> &patterns,
+        const std::vector<hashTools::KeyHash> *patternHashes,
+        std::function<bool(const Content &, const FindPattern &)> less,
+        std::function<bool(const Content &, const FindPattern &)> equal
+    ) override {
+        std::shared_ptr<FilterBase> filter = this->getRegisterInfo().additional;
+        std::vector<std::size_t> passed;
+        std::vector<FindPattern> passedPatterns;
+        for (std::size_t i = 0; i < patterns.size(); ++i) {
+            if (patternHashes
+                ? filter->mightContainHashed(patterns[i], (*patternHashes)[i])
+                : filter->mightContain(patterns[i])) {
+                passed.push_back(i);
+                passedPatterns.push_back(patterns[i]);
+            }
+        }
+        std::vector<std::optional<Content>> found(patterns.size());
+        if (passed.empty()) {
+            return found;
+        }
+        std::vector<std::optional<Content>> passedFound
+            = SortedStorage::findAll(passedPatterns, nullptr, std::move(less), std::move(equal));
+        for (std::size_t i = 0; i < passed.size(); ++i) {
+            found[passed[i]] = std::move(passedFound[i]);
+        }
+        return found;
+    }
 };
 
 } // supermap
@@ -7,7 +7,9 @@ namespace supermap {
 
 /**
  * @brief A storage register, which registers elements
- * in inner filter.
+ * in inner filter. Clones of the register share the inner filter:
+ * once it is sealed it is never modified again, and before that
+ * it is copied by the first clone which registers anything.
  * @tparam RegisterT Register content type.
  * @tparam FilterT Filter content type.
  */
@@ -24,11 +26,21 @@ class FilteringRegister : public StorageItemRegister<RegisterT, std::shared_ptr<
         std::function<FilterT(const RegisterT &)> func
     ) : filter_(filterSupplier()), func_(std::move(func)) {}
 
+    FilteringRegister(const FilteringRegister &other)
+        : filter_(other.filter_),
+          func_(other.func_),
+          sealed_(other.sealed_),
+          copyOnWrite_(!other.sealed_) {
+        if (!other.sealed_) {
+            other.copyOnWrite_ = true;
+        }
+    }
+
     /**
      * @brief Registers an item in storage, by adding it to the inner filter.
      */
     void registerItem(const RegisterT &item) override {
-        filter_->add(func_(item));
+        getOwnFilter().add(func_(item));
     }
 
     /**
@@ -39,14 +51,12 @@ class FilteringRegister : public StorageItemRegister<RegisterT, std::shared_ptr<
     }
 
     /**
-     * @return Ownership of register with same inner filter.
+     * @return Ownership of register with same inner filter, which is copied only when one of registers
+     * modifies it before it is sealed.
      */
     std::unique_ptr<StorageItemRegister<RegisterT, std::shared_ptr<FilterBase>>>
     clone() const override {
-        return std::make_unique<FilteringRegister<RegisterT, FilterT>>(
-            [filter = filter_]() { return filter->clone(); },
-            func_
-        );
+        return std::make_unique<FilteringRegister<RegisterT, FilterT>>(*this);
     }
 
     /**
@@ -54,12 +64,42 @@ class FilteringRegister : public StorageItemRegister<RegisterT, std::shared_ptr<
      * @param n Reservation size.
      */
     void reserve(std::uint64_t n) override {
-        filter_->reserve(n);
+        getOwnFilter().reserve(n);
+    }
+
+    /**
+     * @brief Seals inner filter. After that it is shared by all clones of this register without copying.
+     */
+    void seal() override {
+        if (!sealed_) {
+            getOwnFilter().seal();
+            sealed_ = true;
+        }
+    }
+
+    /**
+     * @return If inner filter is sealed.
+     */
+    [[nodiscard]] bool isSealed() const noexcept {
+        return sealed_;
     }
 
   private:
+    /**
+     * @return Inner filter, which is copied first if it may be shared with another register.
+     */
+    FilterBase &getOwnFilter() {
+        if (copyOnWrite_ && filter_.use_count() > 1) {
+            filter_ = filter_->clone();
+        }
+        copyOnWrite_ = false;
+        return *filter_;
+    }
+
     std::shared_ptr<FilterBase> filter_{};
     std::function<FilterT(const RegisterT &)> func_;
+    bool sealed_ = false;
+    mutable bool copyOnWrite_ = false;
 };
 
 } // supermap
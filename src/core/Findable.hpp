@@ -2,6 +2,9 @@
 
 #include <optional>
 #include <functional>
+#include <vector>
+
+#include "hasher/HashTools.hpp"
 
 namespace supermap {
 
@@ -28,6 +31,48 @@ class Findable {
         std::function<bool(const T &, const P &)> less,
         std::function<bool(const T &, const P &)> equal
     ) = 0;
+
+    /**
+     * @brief Same as @p find, but may use already computed hash of @p pattern instead of hashing it again.
+     * @param pattern Find pattern.
+     * @param patternHash Hash of @p pattern, computed by @p hashTools::hashKey.
+     * @param less Predicate, accepts object from storage and pattern, returns if object is less then pattern.
+     * @param equal Predicate, accepts object from storage and pattern, returns if this is equals to pattern.
+     * @return @p std::nullopt iff object predicate is not fulfilled by any object in all storages,
+     * non-empty @p std::optional<T> otherwise.
+     */
+    virtual std::optional<T> findHashed(
+        const P &pattern,
+        const hashTools::KeyHash &,
+        std::function<bool(const T &, const P &)> less,
+        std::function<bool(const T &, const P &)> equal
+    ) {
+        return find(pattern, std::move(less), std::move(equal));
+    }
+
+    /**
+     * @brief Searches for several patterns at once, which lets storages share work between neighbour patterns.
+     * @param patterns Find patterns, ordered by @p less.
+     * @param patternHashes Hashes of @p patterns, computed by @p hashTools::hashKey, may be @p nullptr.
+     * @param less Predicate, accepts object from storage and pattern, returns if object is less then pattern.
+     * @param equal Predicate, accepts object from storage and pattern, returns if this is equals to pattern.
+     * @return Results of @p find for every pattern, in the same order.
+     */
+    virtual std::vector<std::optional<T>> findAll(
+        const std::vector<P> &patterns,
+        const std::vector<hashTools::KeyHash> *patternHashes,
+        std::function<bool(const T &, const P &)> less,
+        std::function<bool(const T &, const P &)> equal
+    ) {
+        std::vector<std::optional<T>> found;
+        found.reserve(patterns.size());
+        for (std::size_t i = 0; i < patterns.size(); ++i) {
+            found.push_back(patternHashes
+                            ? findHashed(patterns[i], (*patternHashes)[i], less, equal)
+                            : find(patterns[i], less, equal));
+        }
+        return found;
+    }
 };
 
 } // supermap
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "ExtractibleKeyValueStorage.hpp"
+#include "hasher/HashTools.hpp"
+#include "io/SerializeHelper.hpp"
+
+namespace supermap {
+
+/**
+ * @brief Hash table with open addressing and linear probing, which does not keep keys ordered,
+ * so every @p add and @p getValue takes constant expected time. Keys are sorted only on extraction,
+ * with the radix sort by their serialized bytes.
+ * @tparam Key key type, must have fixed serialized size, and its serialized bytes must be
+ * ordered lexicographically in the same way, as keys themselves are, like bytes of @p Key.
+ * @tparam Value value type.
+ * @tparam IndexT storage index type.
+ */
+template <typename Key, typename Value, typename IndexT>
+class HashTable : public ExtractibleKeyValueStorage<Key, Value, IndexT> {
+  private:
+    static constexpr std::size_t KEY_SIZE = io::FixedDeserializedSizeRegister<Key>::exactDeserializedSize;
+
+    /**
+     * @brief Seed of slot hashes. It differs from @p hashTools::KEY_HASH_SEED, so that slots
+     * do not depend on the shard, which key is routed to.
+     */
+    static constexpr std::uint64_t HASH_SEED = 17;
+
+    struct Slot {
+        Key key{};
+        Value value{};
+        bool occupied = false;
+    };
+
+  public:
+    /**
+     * @brief The smallest number of slots.
+     */
+    static constexpr std::size_t MIN_CAPACITY = 16;
+
+    /**
+     * @brief Number of slots is doubled, when keys occupy more than MAX_LOAD_NUMERATOR / MAX_LOAD_DENOMINATOR of them.
+     */
+    static constexpr std::size_t MAX_LOAD_NUMERATOR = 3;
+    static constexpr std::size_t MAX_LOAD_DENOMINATOR = 4;
+
+    /**
+     * @param hasher Hasher of serialized keys.
+     * @param expectedSize Number of keys, which can be added without growing the table.
+     */
+    explicit HashTable(std::unique_ptr<Hasher> &&hasher, std::size_t expectedSize = 0)
+        : hasher_(std::move(hasher)), slots_(getCapacityFor(expectedSize)) {}
+
+    /**
+     * @brief Add key-value pair to the table, replacing the value, if @p key is already there.
+     * @param key Key to add.
+     * @param value Value to add.
+     */
+    void add(const Key &key, Value &&value) override {
+        if ((size_ + 1) * MAX_LOAD_DENOMINATOR > slots_.size() * MAX_LOAD_NUMERATOR) {
+            rehash(slots_.size() * 2);
+        }
+        Slot &slot = slots_[findSlot(key)];
+        if (!slot.occupied) {
+            slot.key = key;
+            slot.occupied = true;
+            ++size_;
+        }
+        slot.value = std::move(value);
+    }
+
+    /**
+     * @return The most relevant @p Value associated with @p key.
+     */
+    std::optional<Value> getValue(const Key &key) override {
+        const Slot &slot = slots_[findSlot(key)];
+        if (!slot.occupied) {
+            return std::nullopt;
+        }
+        return std::optional{slot.value};
+    }
+
+    /**
+     * @return Current number of keys in the table.
+     */
+    IndexT getUpperSizeBound() const override {
+        return static_cast<IndexT>(size_);
+    }
+
+    /**
+     * @brief Removes @p key from the table, shifting the following keys of its probe sequence back,
+     * so that no tombstones are left.
+     */
+    void remove(const Key &key) override {
+        std::size_t hole = findSlot(key);
+        if (!slots_[hole].occupied) {
+            return;
+        }
+        slots_[hole].occupied = false;
+        --size_;
+        const std::size_t mask = slots_.size() - 1;
+        for (std::size_t i = (hole + 1) & mask; slots_[i].occupied; i = (i + 1) & mask) {
+            std::size_t home = getHomeSlot(slots_[i].key);
+            if (((i - home) & mask) >= ((i - hole) & mask)) {
+                slots_[hole] = std::move(slots_[i]);
+                slots_[i].occupied = false;
+                hole = i;
+            }
+        }
+    }
+
+    /**
+     * @brief Move all key-value pairs to the vector in ascending key order, emptying the table.
+     */
+    std::vector<KeyValue<Key, Value>> extract() && override {
+        std::vector<KeyValue<Key, Value>> extracted;
+        extracted.reserve(size_);
+        std::move(*this).extractSorted([&extracted](const KeyValue<Key, Value> &kv) {
+            extracted.push_back(kv);
+        });
+        return extracted;
+    }
+
+    /**
+     * @brief Sorts occupied slots by the radix sort and passes them to @p consumer in ascending key order,
+     * emptying the table.
+     */
+    void extractSorted(const std::function<void(const KeyValue<Key, Value> &)> &consumer) && override {
+        forEachSorted(consumer);
+        slots_ = std::vector<Slot>(MIN_CAPACITY);
+        size_ = 0;
+    }
+
+    /**
+     * @brief Sorts occupied slots by the radix sort and passes them to @p consumer in ascending key order.
+     */
+    void forEachSorted(const std::function<void(const KeyValue<Key, Value> &)> &consumer) const override {
+        std::vector<std::uint32_t> occupied;
+        occupied.reserve(size_);
+        for (std::size_t i = 0; i < slots_.size(); ++i) {
+            if (slots_[i].occupied) {
+                occupied.push_back(static_cast<std::uint32_t>(i));
+            }
+        }
+        for (std::uint32_t i : radixSort(occupied)) {
+            consumer(KeyValue<Key, Value>(slots_[i].key, slots_[i].value));
+        }
+    }
+
+    std::unique_ptr<ExtractibleKeyValueStorage<Key, Value, IndexT>> createLikeThis() const override {
+        return std::make_unique<HashTable<Key, Value, IndexT>>(hasher_->clone());
+    }
+
+  private:
+    static std::size_t getCapacityFor(std::size_t size) {
+        std::size_t capacity = MIN_CAPACITY;
+        while (size * MAX_LOAD_DENOMINATOR > capacity * MAX_LOAD_NUMERATOR) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    std::size_t getHomeSlot(const Key &key) const {
+        return static_cast<std::size_t>(hashTools::hashWith(*hasher_, key, HASH_SEED)) & (slots_.size() - 1);
+    }
+
+    /**
+     * @return Slot, which contains @p key, or the empty slot, where it should be added.
+     */
+    std::size_t findSlot(const Key &key) const {
+        const std::size_t mask = slots_.size() - 1;
+        std::size_t i = getHomeSlot(key);
+        while (slots_[i].occupied && !(slots_[i].key == key)) {
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    void rehash(std::size_t capacity) {
+        std::vector<Slot> old = std::exchange(slots_, std::vector<Slot>(capacity));
+        for (Slot &slot : old) {
+            if (slot.occupied) {
+                slots_[findSlot(slot.key)] = std::move(slot);
+            }
+        }
+    }
+
+    /**
+     * @brief Least significant byte first radix sort of slots by serialized keys.
+     * Passes over bytes, which are the same for all keys, are skipped.
+     * @param slots Indices of slots to sort.
+     * @return Indices of slots, ordered by keys.
+     */
+    std::vector<std::uint32_t> radixSort(const std::vector<std::uint32_t> &slots) const {
+        std::vector<std::uint8_t> bytes(slots.size() * KEY_SIZE);
+        for (std::size_t i = 0; i < slots.size(); ++i) {
+            io::serializeTo(slots_[slots[i]].key, reinterpret_cast<char *>(bytes.data() + i * KEY_SIZE));
+        }
+        std::vector<std::uint32_t> order(slots.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::vector<std::uint32_t> buffer(slots.size());
+        for (std::size_t byte = KEY_SIZE; byte-- > 0;) {
+            std::array<std::size_t, 257> counts{};
+            for (std::uint32_t item : order) {
+                ++counts[bytes[item * KEY_SIZE + byte] + 1];
+            }
+            if (std::find(counts.begin(), counts.end(), slots.size()) != counts.end()) {
+                continue;
+            }
+            std::partial_sum(counts.begin(), counts.end(), counts.begin());
+            for (std::uint32_t item : order) {
+                buffer[counts[bytes[item * KEY_SIZE + byte]]++] = item;
+            }
+            order.swap(buffer);
+        }
+        for (std::uint32_t &item : order) {
+            item = slots[item];
+        }
+        return order;
+    }
+
+    std::unique_ptr<Hasher> hasher_;
+    std::vector<Slot> slots_;
+    std::size_t size_ = 0;
+};
+
+} // supermap
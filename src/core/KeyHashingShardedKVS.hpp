@@ -1,5 +1,8 @@
 #pragma once
 
+#include <mutex>
+#include <shared_mutex>
+
 #include "core/KeyValueStorage.hpp"
 #include "hasher/HashTools.hpp"
 
@@ -7,7 +10,11 @@ namespace supermap {
 
 /**
  * @brief A key-value storage, that manipulates with N smaller key-value storages as shards.
- * Key is assigned to shard if its hash
+ * Key is assigned to shard by its hash, which is computed once per request
+ * and passed to the shard, so that its filters do not hash the key again.
+ * All methods are thread-safe. Every shard is guarded by its own reader-writer lock,
+ * so requests to different shards run in parallel, and so do reads of the same shard.
+ * Nested storages must allow concurrent calls of @p getValue.
  * @tparam Key
  * @tparam Value
  * @tparam IndexT
@@ -19,39 +26,121 @@ template <
 >
 class KeyHashingShardedKVS : public KeyValueStorage<Key, Value, IndexT> {
   private:
-    static constexpr std::uint64_t HASH_SEED = 239;
-
     using KVS = KeyValueStorage<Key, Value, IndexT>;
 
   public:
     explicit KeyHashingShardedKVS(
         std::vector<std::unique_ptr<KVS>> &&nestedStorages,
         std::unique_ptr<Hasher> &&hasher
-    ) : nestedStorages_(std::move(nestedStorages)),
-        hasher_(std::move(hasher)) {}
+    ) : shards_(nestedStorages.size()),
+        hasher_(std::move(hasher)) {
+        for (std::size_t i = 0; i < shards_.size(); ++i) {
+            shards_[i].storage = std::move(nestedStorages[i]);
+        }
+    }
 
     void add(const Key &key, Value &&value) override {
-        nestedStorages_[getShardIdForKey(key)]->add(key, std::move(value));
+        Shard &shard = getShard(hashTools::hashKey(*hasher_, key));
+        std::unique_lock lock(shard.mutex);
+        shard.storage->add(key, std::move(value));
+    }
+
+    void remove(const Key &key) override {
+        Shard &shard = getShard(hashTools::hashKey(*hasher_, key));
+        std::unique_lock lock(shard.mutex);
+        shard.storage->remove(key);
     }
 
     std::optional<Value> getValue(const Key &key) override {
-        return nestedStorages_[getShardIdForKey(key)]->getValue(key);
+        hashTools::KeyHash keyHash = hashTools::hashKey(*hasher_, key);
+        return getShardValue(key, keyHash);
+    }
+
+    std::optional<Value> getValueHashed(const Key &key, const hashTools::KeyHash &keyHash) override {
+        if (!keyHash.isComputedBy(*hasher_)) {
+            return getValue(key);
+        }
+        return getShardValue(key, keyHash);
+    }
+
+    /**
+     * @brief Splits @p keys by shards and reads values of each shard by one @p multiGetHashed under one lock.
+     */
+    std::vector<std::optional<Value>> multiGet(const std::vector<Key> &keys) override {
+        std::vector<hashTools::KeyHash> keyHashes;
+        keyHashes.reserve(keys.size());
+        for (const Key &key : keys) {
+            keyHashes.push_back(hashTools::hashKey(*hasher_, key));
+        }
+        return multiGetHashed(keys, keyHashes);
+    }
+
+    std::vector<std::optional<Value>> multiGetHashed(const std::vector<Key> &keys,
+                                                     const std::vector<hashTools::KeyHash> &keyHashes) override {
+        if (!keyHashes.empty() && !keyHashes.front().isComputedBy(*hasher_)) {
+            return multiGet(keys);
+        }
+        std::vector<std::vector<std::size_t>> positions(shards_.size());
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            positions[getShardId(keyHashes[i])].push_back(i);
+        }
+        std::vector<std::optional<Value>> values(keys.size());
+        for (std::size_t shardId = 0; shardId < shards_.size(); ++shardId) {
+            if (positions[shardId].empty()) {
+                continue;
+            }
+            std::vector<Key> shardKeys;
+            std::vector<hashTools::KeyHash> shardHashes;
+            for (std::size_t i : positions[shardId]) {
+                shardKeys.push_back(keys[i]);
+                shardHashes.push_back(keyHashes[i]);
+            }
+            std::vector<std::optional<Value>> shardValues;
+            {
+                std::shared_lock lock(shards_[shardId].mutex);
+                shardValues = shards_[shardId].storage->multiGetHashed(shardKeys, shardHashes);
+            }
+            for (std::size_t j = 0; j < shardValues.size(); ++j) {
+                values[positions[shardId][j]] = std::move(shardValues[j]);
+            }
+        }
+        return values;
     }
 
     IndexT getUpperSizeBound() const override {
         IndexT size = 0;
-        for (const auto &shard : nestedStorages_) {
-            size += shard->getUpperSizeBound();
+        for (const auto &shard : shards_) {
+            std::shared_lock lock(shard.mutex);
+            size += shard.storage->getUpperSizeBound();
         }
         return size;
     }
 
   private:
-    std::size_t getShardIdForKey(const Key &key) {
-        return hashTools::hashWith(*hasher_, key, HASH_SEED) % nestedStorages_.size();
+    /**
+     * @brief Nested storage with its lock. Shards are aligned to separate cache lines,
+     * so that threads, which lock different shards, do not contend for the same line.
+     */
+    struct alignas(64) Shard {
+        std::unique_ptr<KVS> storage;
+        mutable std::shared_mutex mutex;
+    };
+
+    std::optional<Value> getShardValue(const Key &key, const hashTools::KeyHash &keyHash) {
+        Shard &shard = getShard(keyHash);
+        std::shared_lock lock(shard.mutex);
+        return shard.storage->getValueHashed(key, keyHash);
+    }
+
+    Shard &getShard(const hashTools::KeyHash &keyHash) {
+        return shards_[getShardId(keyHash)];
+    }
+
+    std::size_t getShardId(const hashTools::KeyHash &keyHash) const {
+        return keyHash.value % shards_.size();
     }
 
-    std::vector<std::unique_ptr<KVS>> nestedStorages_;
+    std::vector<Shard> shards_;
     std::unique_ptr<Hasher> hasher_;
 };
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <utility>
+
 #include "io/InputIterator.hpp"
 #include "io/SerializeHelper.hpp"
 #include "io/TemporaryFile.hpp"
@@ -22,6 +24,8 @@ struct StorageValueIgnorer {
  * @brief Storage, which contains keys and associated values.
  * Consists of two parts: the one, where keys are sorted and unique
  * and the one where there is no particular order.
+ * Sorted part items have indices starting from zero, and not sorted part items
+ * have indices starting from the not sorted base, which is not less then sorted part size.
  * @tparam Key key type.
  * @tparam Value value type.
  * @tparam IndexT type of storage index.
@@ -50,20 +54,64 @@ class KeyValueShrinkableStorage : public IndexedStorage<KeyValue<Key, Value>, In
      * @param notSortedStorageFilename Name of file where not sorted key-values will be stored.
      * @param sortedStorageFilename Name of file where shuffled key-values will be stored.
      * @param fileManager Shared access to the file manager.
+     * @param innerRegisterSupplier Supplier of registers of exported key indices.
+     * @param notSortedBase Index of the first item in not sorted storage.
+     * @param appendBufferBytes Size of in-memory buffer of appended key-values.
      */
     explicit KeyValueShrinkableStorage(
         const std::string &notSortedStorageFilename,
         const std::string &sortedStorageFilename,
         std::shared_ptr<io::FileManager> fileManager,
-        InnerRegisterSupplier innerRegisterSupplier
+        InnerRegisterSupplier innerRegisterSupplier,
+        IndexT notSortedBase = 0,
+        std::size_t appendBufferBytes = 0
     ) : IndexedStorage<KeyValue<Key, Value>, IndexT, void>([]() { return std::make_unique<VoidRegister<KV>>(); }),
         sortedStorage_(sortedStorageFilename,
                        fileManager,
                        []() { return std::make_unique<VoidRegister<KV>>(); }),
         notSortedStorage_(notSortedStorageFilename,
                           fileManager,
-                          []() { return std::make_unique<VoidRegister<KV>>(); }),
-        innerRegisterSupplier_(std::move(innerRegisterSupplier)) {
+                          []() { return std::make_unique<VoidRegister<KV>>(); },
+                          appendBufferBytes),
+        innerRegisterSupplier_(std::move(innerRegisterSupplier)),
+        notSortedBase_(notSortedBase),
+        appendBufferBytes_(appendBufferBytes) {
+    }
+
+    /**
+     * @brief Opens storage over existing sorted and not sorted storage files.
+     * @param notSortedStorageFilename Name of file where not sorted key-values are stored.
+     * @param notSortedItemsCount Number of key-values in not sorted storage.
+     * @param sortedStorageFilename Name of file where sorted key-values are stored.
+     * @param sortedItemsCount Number of key-values in sorted storage.
+     * @param fileManager Shared access to the file manager.
+     * @param innerRegisterSupplier Supplier of registers of exported key indices.
+     * @param notSortedBase Index of the first item in not sorted storage.
+     * @param appendBufferBytes Size of in-memory buffer of appended key-values.
+     */
+    explicit KeyValueShrinkableStorage(
+        const std::string &notSortedStorageFilename,
+        IndexT notSortedItemsCount,
+        const std::string &sortedStorageFilename,
+        IndexT sortedItemsCount,
+        std::shared_ptr<io::FileManager> fileManager,
+        InnerRegisterSupplier innerRegisterSupplier,
+        IndexT notSortedBase,
+        std::size_t appendBufferBytes = 0
+    ) : IndexedStorage<KeyValue<Key, Value>, IndexT, void>([]() { return std::make_unique<VoidRegister<KV>>(); }),
+        sortedStorage_(sortedStorageFilename,
+                       fileManager,
+                       sortedItemsCount,
+                       std::make_unique<VoidRegister<KV>>()),
+        notSortedStorage_(notSortedStorageFilename,
+                          fileManager,
+                          notSortedItemsCount,
+                          std::make_unique<VoidRegister<KV>>(),
+                          appendBufferBytes),
+        innerRegisterSupplier_(std::move(innerRegisterSupplier)),
+        notSortedBase_(notSortedBase),
+        appendBufferBytes_(appendBufferBytes) {
+        sortedStorage_.seal();
     }
 
     /**
@@ -91,8 +139,11 @@ class KeyValueShrinkableStorage : public IndexedStorage<KeyValue<Key, Value>, In
                        []() { return std::make_unique<VoidRegister<KV>>(); }),
         notSortedStorage_(notSortedStorageFilename,
                           oldStorage.getFileManager(),
-                          []() { return std::make_unique<VoidRegister<KV>>(); }),
-        innerRegisterSupplier_(oldStorage.innerRegisterSupplier_) {
+                          []() { return std::make_unique<VoidRegister<KV>>(); },
+                          oldStorage.appendBufferBytes_),
+        innerRegisterSupplier_(oldStorage.innerRegisterSupplier_),
+        notSortedBase_(0),
+        appendBufferBytes_(oldStorage.appendBufferBytes_) {
         auto indexIterator = actualIndex.getDataIterator();
         io::OutputIterator<KV> keyValueOutputIterator
             = getFileManager()->template getOutputIterator<KV>(
@@ -115,6 +166,8 @@ class KeyValueShrinkableStorage : public IndexedStorage<KeyValue<Key, Value>, In
             currentBatchIndex = indexIterator.collect(indexBatchSize);
         }
         keyValueOutputIterator.flush();
+        sortedStorage_.seal();
+        notSortedBase_ = sortedStorage_.getItemsCount();
     }
 
     /**
@@ -125,6 +178,40 @@ class KeyValueShrinkableStorage : public IndexedStorage<KeyValue<Key, Value>, In
         sortedStorage_.resetWith(std::move(other.sortedStorage_));
         notSortedStorage_.resetWith(std::move(other.notSortedStorage_));
         innerRegisterSupplier_ = std::move(other.innerRegisterSupplier_);
+        notSortedBase_ = other.notSortedBase_;
+    }
+
+    /**
+     * @brief Replaces sorted part of @p this storage with sorted part of @p shrunk.
+     * Not sorted part stays the same.
+     * @param shrunk Storage without not sorted items, which sorted part
+     * is not longer then not sorted base of @p this. Will be @p moved-from.
+     */
+    void resetSortedWith(KeyValueShrinkableStorage &&shrunk) {
+        assert(shrunk.getNotSortedItemsCount() == 0);
+        assert(shrunk.getSortedItemsCount() <= notSortedBase_);
+        sortedStorage_.resetWith(std::move(shrunk.sortedStorage_));
+    }
+
+    /**
+     * @brief Creates an empty storage, which shares file manager and registers with @p this,
+     * and which item indices continue indices of @p this.
+     * @param notSortedStorageFilename Name of file where not sorted key-values will be stored.
+     * @param sortedStorageFilename Name of file where shuffled key-values will be stored.
+     * @return Created storage.
+     */
+    [[nodiscard]] KeyValueShrinkableStorage createNextGeneration(
+        const std::string &notSortedStorageFilename,
+        const std::string &sortedStorageFilename
+    ) const {
+        return KeyValueShrinkableStorage(
+            notSortedStorageFilename,
+            sortedStorageFilename,
+            getFileManager(),
+            innerRegisterSupplier_,
+            getItemsCount(),
+            appendBufferBytes_
+        );
     }
 
     /**
@@ -142,9 +229,23 @@ class KeyValueShrinkableStorage : public IndexedStorage<KeyValue<Key, Value>, In
     }
 
     /**
-     * @return File accosted with not sorted storage.
+     * @return Path of the sorted storage file.
      */
-    [[nodiscard]] std::shared_ptr<io::TemporaryFile> shareNotSortedStorageFile() const noexcept {
+    [[nodiscard]] std::string getSortedStorageFilePath() const noexcept {
+        return sortedStorage_.getStorageFilePath();
+    }
+
+    /**
+     * @return Path of the not sorted storage file.
+     */
+    [[nodiscard]] std::string getNotSortedStorageFilePath() const noexcept {
+        return notSortedStorage_.getStorageFilePath();
+    }
+
+    /**
+     * @return File accosted with not sorted storage. Storage must be flushed.
+     */
+    [[nodiscard]] std::shared_ptr<io::TemporaryFile> shareNotSortedStorageFile() const {
         return notSortedStorage_.shareStorageFile();
     }
 
@@ -158,6 +259,13 @@ class KeyValueShrinkableStorage : public IndexedStorage<KeyValue<Key, Value>, In
         notSortedStorage_.append(std::move(item));
     }
 
+    /**
+     * @brief Writes all buffered key-values to the not sorted storage file.
+     */
+    void flush() {
+        notSortedStorage_.flush();
+    }
+
     /**
      * @brief Gets key-value pair which has index @p index in this storage.
      * Behavior is undefined if index overflows storage size.
@@ -165,17 +273,25 @@ class KeyValueShrinkableStorage : public IndexedStorage<KeyValue<Key, Value>, In
      * @return Read key-value pair.
      */
     KV get(IndexT index) const override {
-        if (index >= sortedStorage_.getItemsCount()) {
-            return notSortedStorage_.get(index - sortedStorage_.getItemsCount());
+        if (index >= notSortedBase_) {
+            return notSortedStorage_.get(index - notSortedBase_);
         }
         return sortedStorage_.get(index);
     }
 
     /**
-     * @return Number of key-value pairs in storage (sum of sorted and not sorted storage sizes).
+     * @return Index of the next appended key-value pair. Equals to the sum of sorted
+     * and not sorted storage sizes, unless sorted part was replaced with @p resetSortedWith.
      */
     [[nodiscard]] IndexT getItemsCount() const noexcept override {
-        return sortedStorage_.getItemsCount() + notSortedStorage_.getItemsCount();
+        return notSortedBase_ + notSortedStorage_.getItemsCount();
+    }
+
+    /**
+     * @return Index of the first key-value pair in not sorted storage.
+     */
+    [[nodiscard]] IndexT getNotSortedBase() const noexcept {
+        return notSortedBase_;
     }
 
     /**
@@ -203,6 +319,7 @@ class KeyValueShrinkableStorage : public IndexedStorage<KeyValue<Key, Value>, In
      * @return Not sorted keys input iterator.
      */
     io::InputIterator<ValueIgnorer, IndexT> getNotSortedKeys() {
+        flush();
         return notSortedStorage_.template getCustomDataIterator<ValueIgnorer>();
     }
 
@@ -217,6 +334,7 @@ class KeyValueShrinkableStorage : public IndexedStorage<KeyValue<Key, Value>, In
      * @return Not sorted entries input iterator.
      */
     io::InputIterator<KV, IndexT> getNotSortedEntries() {
+        flush();
         return notSortedStorage_.getDataIterator();
     }
 
@@ -231,27 +349,42 @@ class KeyValueShrinkableStorage : public IndexedStorage<KeyValue<Key, Value>, In
      * @return Sorted storage of @p KeyValue<Key,IndexT>
      */
     [[nodiscard]] KeyIndexStorage shrink(IndexT shrinkBatchSize, const std::string &newIndexFileName) {
+        flush();
+        auto [shrunk, actualIndex] = shrinkToNew(shrinkBatchSize, "shrink", newIndexFileName);
+        resetWith(std::move(shrunk));
+        return std::move(actualIndex);
+    }
 
-        const std::string shrinkFilenamePrefix = "shrink";
+    /**
+     * @brief Creates shrunk copy of this storage. Unlike @p shrink, does not change
+     * @p this, so it can be read concurrently. Storage must be flushed.
+     * @param shrinkBatchSize The size of the batch of
+     * @p KeyValue<T,IndexT> objects that are simultaneously stored in RAM.
+     * @param shrinkFilenamePrefix Prefix of all files, created during shrink.
+     * @param newIndexFileName File, where new index with the most relevant key
+     * value positions will be stored.
+     * @return Storage, where the most relevant values are paired with keys in sorted storage,
+     * and its index of @p KeyValue<Key,IndexT>.
+     */
+    [[nodiscard]] std::pair<KeyValueShrinkableStorage, KeyIndexStorage> shrinkToNew(
+        IndexT shrinkBatchSize,
+        const std::string &shrinkFilenamePrefix,
+        const std::string &newIndexFileName
+    ) const {
         const std::string tempSortedIndexFilename = shrinkFilenamePrefix + "-sorted-keys";
 
         std::size_t batchesCount = (notSortedStorage_.getItemsCount() + shrinkBatchSize - 1) / shrinkBatchSize;
-        auto notSortedKeysStream = getNotSortedKeys();
-        std::vector<std::shared_ptr<io::TemporaryFile>> tempFilesLock;
+        auto notSortedKeysStream = notSortedStorage_.template getCustomDataIterator<ValueIgnorer>();
         std::vector<KeyIndexStorage> sortedBatches;
         sortedBatches.reserve(batchesCount + 1);
-        tempFilesLock.reserve(batchesCount + 1);
-
-        KeyIndexStorage exportedKeys = exportKeys(shrinkBatchSize, tempSortedIndexFilename);
-        tempFilesLock.push_back(exportedKeys.shareStorageFile());
 
-        sortedBatches.push_back(std::move(exportedKeys));
-        IndexT sortedStorageSize = sortedStorage_.getItemsCount();
+        sortedBatches.push_back(exportKeys(shrinkBatchSize, tempSortedIndexFilename));
+        IndexT notSortedBase = notSortedBase_;
         for (std::size_t batchI = 0; batchI < batchesCount; ++batchI) {
             const std::string batchFileName = shrinkFilenamePrefix + "-batch-" + std::to_string(batchI);
             std::vector<KeyIndex> notSortedKeys = notSortedKeysStream.collectWith(
-                [sortedStorageSize](ValueIgnorer &&svi, IndexT index) {
-                    return KeyIndex{std::move(svi.key), index + sortedStorageSize};
+                [notSortedBase](ValueIgnorer &&svi, IndexT index) {
+                    return KeyIndex{std::move(svi.key), index + notSortedBase};
                 },
                 shrinkBatchSize
             );
@@ -265,32 +398,28 @@ class KeyValueShrinkableStorage : public IndexedStorage<KeyValue<Key, Value>, In
                 [](const KeyIndex &a, const KeyIndex &b) { return a.key == b.key; },
                 innerRegisterSupplier_
             );
-            tempFilesLock.push_back(sortedBatch.shareStorageFile());
             assert(sortedBatch.getItemsCount() > 0 && "Batch file can not be empty");
             sortedBatches.push_back(std::move(sortedBatch));
         }
 
         KeyIndexStorage updatedIndex(
             sortedBatches,
-            newIndexFileName,
+            shrinkFilenamePrefix + "-merged-index",
             getFileManager(),
             shrinkBatchSize,
             innerRegisterSupplier_
         );
+        sortedBatches.clear();
 
-        resetWith(KeyValueShrinkableStorage(
+        KeyValueShrinkableStorage shrunk(
             *this,
             updatedIndex,
             shrinkFilenamePrefix + "-new-not-sorted",
             shrinkFilenamePrefix + "-new-sorted",
             shrinkBatchSize
-        ));
-
-        KeyIndexStorage actualExportedKeys
-            = exportKeys(shrinkBatchSize, shrinkFilenamePrefix + "-actual-index");
-        tempFilesLock.push_back(actualExportedKeys.shareStorageFile());
-        updatedIndex.resetWith(std::move(actualExportedKeys));
-        return updatedIndex;
+        );
+        KeyIndexStorage actualIndex = shrunk.exportKeys(shrinkBatchSize, newIndexFileName);
+        return {std::move(shrunk), std::move(actualIndex)};
     }
 
   private:
@@ -301,7 +430,7 @@ class KeyValueShrinkableStorage : public IndexedStorage<KeyValue<Key, Value>, In
      * @param keysFilename Name of export file.
      * @return Storage instance.
      */
-    KeyIndexStorage exportKeys(IndexT batchSize, const std::string &keysFilename) {
+    KeyIndexStorage exportKeys(IndexT batchSize, const std::string &keysFilename) const {
         KeyIndexStorage sortedIndex(keysFilename, getFileManager(), innerRegisterSupplier_);
         auto it = sortedStorage_.template getCustomDataIterator<ValueIgnorer>();
         auto keys = it.collectWith([](ValueIgnorer &&kvi, IndexT ind) {
@@ -314,12 +443,15 @@ class KeyValueShrinkableStorage : public IndexedStorage<KeyValue<Key, Value>, In
                 return KeyIndex{std::move(kvi.key), ind};
             }, batchSize);
         }
+        sortedIndex.seal();
         return sortedIndex;
     }
 
     SortedSingleFileIndexedStorage<KV, IndexT, void, Key> sortedStorage_;
     SingleFileIndexedStorage<KV, IndexT, void> notSortedStorage_;
     InnerRegisterSupplier innerRegisterSupplier_;
+    IndexT notSortedBase_;
+    std::size_t appendBufferBytes_;
 };
 
 namespace io {
@@ -345,6 +477,15 @@ struct DeserializeHelper<StorageValueIgnorer<Key, Value>> : Deserializable<true>
         }
         return svi;
     }
+
+    /**
+     * @brief Deserializes @p StorageValueIgnorer from memory @p src, reading only the key.
+     * @param src Serialized key-value pair memory.
+     * @return StorageValueIgnorer instance.
+     */
+    static StorageValueIgnorer<Key, Value> deserializeFrom(const char *src) {
+        return StorageValueIgnorer<Key, Value>{io::deserializeFrom<Key>(src)};
+    }
 };
 
 /**
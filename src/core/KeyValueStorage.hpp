@@ -1,8 +1,10 @@
 #pragma once
 
 #include "exception/SupermapException.hpp"
+#include "hasher/HashTools.hpp"
 
 #include <optional>
+#include <vector>
 
 namespace supermap {
 
@@ -34,6 +36,42 @@ class KeyValueStorage {
      */
     virtual std::optional<Value> getValue(const Key &key) = 0;
 
+    /**
+     * @brief Same as @p getValue, but may use already computed hash of @p key instead of hashing it again.
+     * @param key Key to get value.
+     * @param keyHash Hash of @p key, computed by @p hashTools::hashKey.
+     * @return Non-empty @p std::optional<Value> is value associated with the given @p key
+     * exists, @p std::nullopt otherwise.
+     */
+    virtual std::optional<Value> getValueHashed(const Key &key, const hashTools::KeyHash &) {
+        return getValue(key);
+    }
+
+    /**
+     * @brief Reads values associated with every key of @p keys.
+     * @param keys Keys to get values, may be in any order and may repeat.
+     * @return Results of @p getValue for every key, in the same order.
+     */
+    virtual std::vector<std::optional<Value>> multiGet(const std::vector<Key> &keys) {
+        std::vector<std::optional<Value>> values;
+        values.reserve(keys.size());
+        for (const Key &key : keys) {
+            values.push_back(getValue(key));
+        }
+        return values;
+    }
+
+    /**
+     * @brief Same as @p multiGet, but may use already computed hashes of @p keys instead of hashing them again.
+     * @param keys Keys to get values.
+     * @param keyHashes Hashes of @p keys, computed by @p hashTools::hashKey.
+     * @return Results of @p getValue for every key, in the same order.
+     */
+    virtual std::vector<std::optional<Value>> multiGetHashed(const std::vector<Key> &keys,
+                                                             const std::vector<hashTools::KeyHash> &) {
+        return multiGet(keys);
+    }
+
     /**
      * @brief Checks if storage contains @p key.
      * @param key Key to find.
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+
+#include "Filter.hpp"
+#include "io/FileManager.hpp"
+#include "exception/IllegalStateException.hpp"
+
+namespace supermap {
+
+/**
+ * @brief Filter, which state is saved in a file, and is read only when it is needed for the first time.
+ * Elements can not be added to such filter. All methods are thread-safe.
+ * @tparam T Type of elements.
+ */
+template <typename T>
+class LazyFilter : public Filter<T> {
+  public:
+    /**
+     * @param fileManager Manager of the filter file.
+     * @param path Path of the file, where the filter was saved with @p Filter::save.
+     * @param emptyFilter Filter of the same type as the saved one, which state will be restored from the file.
+     */
+    LazyFilter(std::shared_ptr<io::FileManager> fileManager,
+               std::filesystem::path path,
+               std::unique_ptr<Filter<T>> &&emptyFilter)
+        : fileManager_(std::move(fileManager)),
+          path_(std::move(path)),
+          inner_(std::move(emptyFilter)) {}
+
+    LazyFilter(const LazyFilter &other)
+        : fileManager_(other.fileManager_),
+          path_(other.path_),
+          inner_(other.getLoaded().clone()) {
+        markLoaded();
+    }
+
+    /**
+     * @throws IllegalStateException always, since saved filter is immutable.
+     */
+    void add(const T &) override {
+        throw supermap::IllegalStateException("Elements can not be added to the saved filter");
+    }
+
+    /**
+     * @brief Reads the filter, if it was not read yet, and checks @p elem.
+     */
+    [[nodiscard]] bool mightContain(const T &elem) const override {
+        return getLoaded().mightContain(elem);
+    }
+
+    /**
+     * @brief Reads the filter, if it was not read yet, and checks @p elem with its hash @p elemHash.
+     */
+    [[nodiscard]] bool mightContainHashed(const T &elem, const hashTools::KeyHash &elemHash) const override {
+        return getLoaded().mightContainHashed(elem, elemHash);
+    }
+
+    std::unique_ptr<Filter<T>> clone() const override {
+        return std::make_unique<LazyFilter<T>>(*this);
+    }
+
+    void save(std::ostream &os) const override {
+        getLoaded().save(os);
+    }
+
+    void restore(std::istream &is) override {
+        markLoaded();
+        inner_->restore(is);
+    }
+
+    /**
+     * @return Memory of the filter, or @p 0 if it was not read yet.
+     */
+    [[nodiscard]] std::uint64_t getMemoryBits() const override {
+        return isLoaded() ? inner_->getMemoryBits() : 0;
+    }
+
+    [[nodiscard]] double getFalsePositiveProbability() const override {
+        return getLoaded().getFalsePositiveProbability();
+    }
+
+    /**
+     * @return If the filter has been already read from the file.
+     */
+    [[nodiscard]] bool isLoaded() const noexcept {
+        return isLoaded_.load(std::memory_order_acquire);
+    }
+
+  private:
+    /**
+     * @brief Marks filter as read, so that it is never read from the file.
+     */
+    void markLoaded() {
+        std::call_once(loaded_, []() {});
+        isLoaded_.store(true, std::memory_order_release);
+    }
+
+    /**
+     * @return Filter, read from the file.
+     */
+    const Filter<T> &getLoaded() const {
+        std::call_once(loaded_, [this]() {
+            auto input = fileManager_->getInputStream(path_, 0);
+            inner_->restore(input->get());
+            isLoaded_.store(true, std::memory_order_release);
+        });
+        return *inner_;
+    }
+
+    std::shared_ptr<io::FileManager> fileManager_;
+    std::filesystem::path path_;
+    std::unique_ptr<Filter<T>> inner_;
+    mutable std::once_flag loaded_;
+    mutable std::atomic<bool> isLoaded_ = false;
+};
+
+} // supermap
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "io/FileManager.hpp"
+#include "io/ShallowSerializer.hpp"
+
+namespace supermap {
+
+/**
+ * @brief Persistent description of the @p Supermap state. Lists all live data and index files
+ * with their sizes, and keeps in-memory metadata of index storages: fences and paths of their saved filters.
+ * Storage may be reopened from the manifest without reading any data file.
+ * Manifest is replaced atomically, so after a crash either the old or the new manifest is found.
+ * @tparam IndexItem Type of index storages content.
+ * @tparam IndexT Type of storage index.
+ */
+template <typename IndexItem, typename IndexT>
+struct Manifest {
+    /**
+     * @brief Name of the manifest file.
+     */
+    static constexpr const char *FILE_NAME = "MANIFEST";
+
+    /**
+     * @brief Version of the manifest format. Manifests of other versions are not read.
+     */
+    static constexpr std::uint64_t FORMAT_VERSION = 3;
+
+    /**
+     * @brief State of one sorted index storage.
+     */
+    struct IndexStorageState {
+        std::string path;
+        IndexT itemsCount;
+        std::vector<IndexItem> fences;
+        std::string filterPath;
+    };
+
+    std::string notSortedPath;
+    IndexT notSortedItemsCount{};
+    std::string sortedPath;
+    IndexT sortedItemsCount{};
+    IndexT notSortedBase{};
+    std::optional<IndexStorageState> baseIndex;
+
+    /**
+     * @brief Index of the not sorted part of data storage, from the most to the least relevant storage.
+     */
+    std::vector<IndexStorageState> indexStorages;
+
+    /**
+     * @return Paths of all files, which are referenced by the manifest.
+     */
+    [[nodiscard]] std::unordered_set<std::string> getReferencedFiles() const {
+        std::unordered_set<std::string> files{notSortedPath, sortedPath};
+        if (baseIndex.has_value()) {
+            files.insert({baseIndex->path, baseIndex->filterPath});
+        }
+        for (const auto &storage : indexStorages) {
+            files.insert({storage.path, storage.filterPath});
+        }
+        return files;
+    }
+
+    /**
+     * @brief Writes the manifest to the temporary file, synchronizes it and renames to @p FILE_NAME.
+     * All referenced files must be synchronized before.
+     * @param fileManager Manager of the storage files.
+     */
+    void write(io::FileManager &fileManager) const {
+        const std::string newManifest = std::string(FILE_NAME) + "-new";
+        {
+            auto output = fileManager.getOutputStream(newManifest, false);
+            std::ostream &os = output->get();
+            writeNumber(FORMAT_VERSION, os);
+            writeString(notSortedPath, os);
+            writeNumber(notSortedItemsCount, os);
+            writeString(sortedPath, os);
+            writeNumber(sortedItemsCount, os);
+            writeNumber(notSortedBase, os);
+            writeNumber(baseIndex.has_value() ? 1 : 0, os);
+            if (baseIndex.has_value()) {
+                writeIndexStorage(baseIndex.value(), os);
+            }
+            writeNumber(indexStorages.size(), os);
+            for (const auto &storage : indexStorages) {
+                writeIndexStorage(storage, os);
+            }
+            output->sync();
+        }
+        fileManager.rename(newManifest, FILE_NAME);
+    }
+
+    /**
+     * @brief Reads the manifest @p FILE_NAME.
+     * @param fileManager Manager of the storage files.
+     * @return Read manifest, or @p std::nullopt if there is no manifest.
+     * @throws IOException if manifest is corrupted or has other format version.
+     */
+    static std::optional<Manifest> read(io::FileManager &fileManager) {
+        if (!fileManager.exists(FILE_NAME)) {
+            return std::nullopt;
+        }
+        auto input = fileManager.getInputStream(FILE_NAME, 0);
+        std::istream &is = input->get();
+        if (readNumber(is) != FORMAT_VERSION) {
+            throw IOException("Unsupported manifest format version");
+        }
+        Manifest manifest;
+        manifest.notSortedPath = readString(is);
+        manifest.notSortedItemsCount = static_cast<IndexT>(readNumber(is));
+        manifest.sortedPath = readString(is);
+        manifest.sortedItemsCount = static_cast<IndexT>(readNumber(is));
+        manifest.notSortedBase = static_cast<IndexT>(readNumber(is));
+        if (readNumber(is) != 0) {
+            manifest.baseIndex = readIndexStorage(is);
+        }
+        std::uint64_t storagesCount = readNumber(is);
+        for (std::uint64_t i = 0; i < storagesCount; ++i) {
+            manifest.indexStorages.push_back(readIndexStorage(is));
+        }
+        if (!is.good()) {
+            throw IOException("Manifest is corrupted");
+        }
+        return manifest;
+    }
+
+  private:
+    static void writeNumber(std::uint64_t number, std::ostream &os) {
+        io::serialize(number, os);
+    }
+
+    static std::uint64_t readNumber(std::istream &is) {
+        return io::deserialize<std::uint64_t>(is);
+    }
+
+    static void writeString(const std::string &string, std::ostream &os) {
+        writeNumber(string.size(), os);
+        os.write(string.data(), static_cast<std::streamsize>(string.size()));
+    }
+
+    static std::string readString(std::istream &is) {
+        std::string string(readNumber(is), '\0');
+        is.read(string.data(), static_cast<std::streamsize>(string.size()));
+        return string;
+    }
+
+    static void writeIndexStorage(const IndexStorageState &storage, std::ostream &os) {
+        writeString(storage.path, os);
+        writeNumber(storage.itemsCount, os);
+        writeNumber(storage.fences.size(), os);
+        for (const auto &fence : storage.fences) {
+            io::serialize(fence, os);
+        }
+        writeString(storage.filterPath, os);
+    }
+
+    static IndexStorageState readIndexStorage(std::istream &is) {
+        IndexStorageState storage;
+        storage.path = readString(is);
+        storage.itemsCount = static_cast<IndexT>(readNumber(is));
+        std::uint64_t fencesCount = readNumber(is);
+        storage.fences.reserve(fencesCount);
+        for (std::uint64_t i = 0; i < fencesCount; ++i) {
+            storage.fences.push_back(io::deserialize<IndexItem>(is));
+        }
+        storage.filterPath = readString(is);
+        return storage;
+    }
+};
+
+} // supermap
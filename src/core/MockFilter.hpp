@@ -34,6 +34,16 @@ class MockFilter : public Filter<T> {
     std::unique_ptr<Filter<T>> clone() const override {
         return std::make_unique<MockFilter<T>>();
     }
+
+    /**
+     * @brief Filter is mock, so there is no state to save.
+     */
+    void save(std::ostream &) const override {}
+
+    /**
+     * @brief Filter is mock, so there is no state to restore.
+     */
+    void restore(std::istream &) override {}
 };
 
 } // supermap
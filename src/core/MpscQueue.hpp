@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+namespace supermap {
+
+/**
+ * @brief Unbounded lock-free queue, to which any number of threads push, and from which one thread pops.
+ * Pushing is a single atomic exchange, popping does not use atomic read-modify-write operations at all.
+ * Pushed item may be invisible to the consumer for a moment, until its producer links it to the previous one.
+ * @tparam T Type of items.
+ */
+template <typename T>
+class MpscQueue {
+  private:
+    struct Node {
+        std::atomic<Node *> next = nullptr;
+        std::optional<T> value;
+    };
+
+  public:
+    MpscQueue() : head_(new Node), tail_(head_.load()) {}
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    ~MpscQueue() {
+        while (pop().has_value()) {}
+        delete tail_;
+    }
+
+    /**
+     * @brief Pushes @p value to the queue. May be called by any thread.
+     */
+    void push(T &&value) {
+        Node *node = new Node;
+        node->value.emplace(std::move(value));
+        Node *previous = head_.exchange(node);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    /**
+     * @brief Pops the oldest item from the queue. May be called by the consumer thread only.
+     * @return Popped item, or @p std::nullopt if there is no item, which is visible to the consumer.
+     */
+    std::optional<T> pop() {
+        Node *next = tail_->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            return std::nullopt;
+        }
+        delete tail_;
+        tail_ = next;
+        return std::exchange(next->value, std::nullopt);
+    }
+
+    /**
+     * @return If no item has been pushed since the last pop. May be called by the consumer thread only.
+     */
+    [[nodiscard]] bool empty() const {
+        return head_.load() == tail_;
+    }
+
+  private:
+    std::atomic<Node *> head_;
+    Node *tail_;
+};
+
+} // supermap
@@ -22,6 +22,13 @@ class OrderedStorage {
     explicit OrderedStorage(typename CountingRegister::InnerRegisterSupplier registerSupplier)
         : register_(std::move(registerSupplier)) {}
 
+    /**
+     * @param itemsCount Number of items, which storage already contains.
+     * @param innerRegister Register, which has already registered all contained items.
+     */
+    explicit OrderedStorage(IndexT itemsCount, std::unique_ptr<typename CountingRegister::InnerRegister> &&innerRegister)
+        : register_(itemsCount, std::move(innerRegister)) {}
+
     /**
      * @brief Add element to the end of storage (which will have the greatest order).
      * Order of added element is @p getLastElementIndex().
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <functional>
+
+#include "Filter.hpp"
+#include "FilterPolicy.hpp"
+#include "io/ShallowSerializer.hpp"
+#include "exception/IllegalStateException.hpp"
+
+namespace supermap {
+
+/**
+ * @brief Filter, which is sized by the @p FilterPolicy when its size is reserved.
+ * The actual filter is created with the number of bits per key, given by the policy.
+ * If the policy gives no bits, nothing is filtered.
+ * @tparam T Type of elements.
+ */
+template <typename T>
+class PolicyDrivenFilter : public Filter<T> {
+  public:
+    using FilterFactory = std::function<std::unique_ptr<Filter<T>>(double bitsPerKey)>;
+
+    /**
+     * @param policy Filter memory policy.
+     * @param factory Creates actual filter with the given number of bits per key, which is at least 1.
+     */
+    PolicyDrivenFilter(std::shared_ptr<const FilterPolicy> policy, FilterFactory factory)
+        : policy_(std::move(policy)), factory_(std::move(factory)) {}
+
+    PolicyDrivenFilter(const PolicyDrivenFilter &other)
+        : policy_(other.policy_),
+          factory_(other.factory_),
+          inner_(other.inner_ ? other.inner_->clone() : nullptr),
+          wasReserved_(other.wasReserved_) {}
+
+    /**
+     * @throws IllegalStateException if filter size was not reserved.
+     */
+    void add(const T &elem) override {
+        checkReserved();
+        if (inner_) {
+            inner_->add(elem);
+        }
+    }
+
+    /**
+     * @throws IllegalStateException if filter size was not reserved.
+     */
+    [[nodiscard]] bool mightContain(const T &elem) const override {
+        checkReserved();
+        return !inner_ || inner_->mightContain(elem);
+    }
+
+    /**
+     * @throws IllegalStateException if filter size was not reserved.
+     */
+    [[nodiscard]] bool mightContainHashed(const T &elem, const hashTools::KeyHash &elemHash) const override {
+        checkReserved();
+        return !inner_ || inner_->mightContainHashed(elem, elemHash);
+    }
+
+    std::unique_ptr<Filter<T>> clone() const override {
+        return std::make_unique<PolicyDrivenFilter<T>>(*this);
+    }
+
+    /**
+     * @brief Creates the actual filter for @p n elements, sized by the policy.
+     * @throws IllegalStateException if filter size has been already reserved.
+     */
+    void reserve(std::uint64_t n) override {
+        if (wasReserved_) {
+            throw supermap::IllegalStateException("Filter size has been already reserved");
+        }
+        wasReserved_ = true;
+        double bitsPerKey = policy_->getBitsPerKey(n);
+        if (bitsPerKey >= 1) {
+            inner_ = factory_(bitsPerKey);
+            inner_->reserve(n);
+        }
+    }
+
+    void seal() override {
+        if (inner_) {
+            inner_->seal();
+        }
+    }
+
+    void save(std::ostream &os) const override {
+        io::serialize<std::uint64_t>(inner_ ? 1 : 0, os);
+        if (inner_) {
+            inner_->save(os);
+        }
+    }
+
+    void restore(std::istream &is) override {
+        inner_.reset();
+        if (io::deserialize<std::uint64_t>(is) != 0) {
+            inner_ = factory_(1);
+            inner_->restore(is);
+        }
+        wasReserved_ = true;
+    }
+
+    [[nodiscard]] std::uint64_t getMemoryBits() const override {
+        return inner_ ? inner_->getMemoryBits() : 0;
+    }
+
+    [[nodiscard]] double getFalsePositiveProbability() const override {
+        return inner_ ? inner_->getFalsePositiveProbability() : 1;
+    }
+
+  private:
+    void checkReserved() const {
+        if (!wasReserved_) {
+            throw supermap::IllegalStateException("Filter size was not reserved");
+        }
+    }
+
+    std::shared_ptr<const FilterPolicy> policy_;
+    FilterFactory factory_;
+    std::unique_ptr<Filter<T>> inner_;
+    bool wasReserved_ = false;
+};
+
+} // supermap
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "KeyValueStorage.hpp"
+#include "MpscQueue.hpp"
+
+namespace supermap {
+
+/**
+ * @brief Thread, which exclusively owns a key-value storage and executes all requests to it.
+ * Requests come through the lock-free queue and are executed in batches, in the order they were queued.
+ * The thread falls asleep only when there are no requests for a while.
+ * @tparam Key type of key.
+ * @tparam Value type of value.
+ * @tparam IndexT type of storage size.
+ */
+template <typename Key, typename Value, typename IndexT>
+class ShardWorker {
+  private:
+    using KVS = KeyValueStorage<Key, Value, IndexT>;
+
+    class Task {
+      public:
+        virtual void run(KVS &storage) = 0;
+        virtual ~Task() = default;
+    };
+
+    template <typename R>
+    class PackagedTask : public Task {
+      public:
+        explicit PackagedTask(std::packaged_task<R(KVS &)> &&task) : task_(std::move(task)) {}
+
+        void run(KVS &storage) override {
+            task_(storage);
+        }
+
+      private:
+        std::packaged_task<R(KVS &)> task_;
+    };
+
+  public:
+    /**
+     * @brief The largest number of requests, executed without looking at the stop flag.
+     */
+    static constexpr std::size_t MAX_BATCH_SIZE = 256;
+
+    /**
+     * @brief Number of times the idle thread yields before falling asleep.
+     */
+    static constexpr std::size_t IDLE_SPINS = 64;
+
+    /**
+     * @param storage Storage, which is owned by the worker.
+     * @param core Index of CPU core, which the worker thread is pinned to, or @p std::nullopt if it is not pinned.
+     * Pinning is best effort: it is done only on Linux, and its failure is ignored.
+     */
+    ShardWorker(std::unique_ptr<KVS> &&storage, std::optional<std::size_t> core)
+        : storage_(std::move(storage)),
+          thread_([this, core]() { run(core); }) {}
+
+    ShardWorker(const ShardWorker &) = delete;
+    ShardWorker &operator=(const ShardWorker &) = delete;
+
+    /**
+     * @brief Executes all queued requests and stops the thread.
+     */
+    ~ShardWorker() {
+        stopping_.store(true);
+        wakeUp();
+        thread_.join();
+    }
+
+    /**
+     * @brief Queues @p f to be called with the owned storage by the worker thread. May be called by any thread.
+     * @return Future of the @p f result, or of its exception.
+     */
+    template <typename F>
+    std::future<std::invoke_result_t<F, KVS &>> submit(F &&f) {
+        using R = std::invoke_result_t<F, KVS &>;
+        std::packaged_task<R(KVS &)> task(std::forward<F>(f));
+        std::future<R> result = task.get_future();
+        queue_.push(std::make_unique<PackagedTask<R>>(std::move(task)));
+        if (sleeping_.load()) {
+            wakeUp();
+        }
+        return result;
+    }
+
+  private:
+    void run(std::optional<std::size_t> core) {
+        if (core.has_value()) {
+            pinCurrentThread(core.value());
+        }
+        std::size_t idleSpins = 0;
+        while (true) {
+            if (executeBatch() > 0) {
+                idleSpins = 0;
+            } else if (stopping_.load() && queue_.empty()) {
+                return;
+            } else if (++idleSpins < IDLE_SPINS) {
+                std::this_thread::yield();
+            } else {
+                sleep();
+                idleSpins = 0;
+            }
+        }
+    }
+
+    /**
+     * @return Number of executed requests.
+     */
+    std::size_t executeBatch() {
+        std::size_t executed = 0;
+        for (; executed < MAX_BATCH_SIZE; ++executed) {
+            std::optional<std::unique_ptr<Task>> task = queue_.pop();
+            if (!task.has_value()) {
+                break;
+            }
+            task.value()->run(*storage_);
+        }
+        return executed;
+    }
+
+    /**
+     * @brief Waits until a request is queued or the worker is stopped. Producers see @p sleeping_
+     * set before the queue is checked, so the request, which was queued after the check, wakes the worker up.
+     */
+    void sleep() {
+        std::unique_lock lock(mutex_);
+        sleeping_.store(true);
+        wakeUpCondition_.wait(lock, [this]() { return !queue_.empty() || stopping_.load(); });
+        sleeping_.store(false);
+    }
+
+    void wakeUp() {
+        {
+            std::lock_guard lock(mutex_);
+        }
+        wakeUpCondition_.notify_one();
+    }
+
+    static void pinCurrentThread([[maybe_unused]] std::size_t core) {
+#ifdef __linux__
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(core, &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#endif
+    }
+
+    std::unique_ptr<KVS> storage_;
+    MpscQueue<std::unique_ptr<Task>> queue_;
+    std::atomic<bool> sleeping_ = false;
+    std::atomic<bool> stopping_ = false;
+    std::mutex mutex_;
+    std::condition_variable wakeUpCondition_;
+    std::thread thread_;
+};
+
+} // supermap
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "io/FileManager.hpp"
 #include "io/TemporaryFile.hpp"
@@ -12,6 +14,9 @@ namespace supermap {
 
 /**
  * @brief Indexed storage that stores all items in the single file.
+ * Keeps the file opened for appending, and may buffer appended items in memory.
+ * Buffered items are visible to @p get, and are written to the file by @p flush.
+ * Reading the file or sharing it requires the storage to be flushed.
  * @tparam T Contained objects type.
  * @tparam IndexT Contained objects index.
  * @tparam RegisterInfo Type of inner item register info.
@@ -20,6 +25,7 @@ template <typename T, typename IndexT, typename RegisterInfo>
 class SingleFileIndexedStorage : public IndexedStorage<T, IndexT, RegisterInfo> {
   public:
     using OrdStorage = OrderedStorage<T, IndexT, RegisterInfo>;
+    using InnerRegister = typename OrdStorage::CountingRegister::InnerRegister;
     using InnerRegisterSupplier = typename OrdStorage::CountingRegister::InnerRegisterSupplier;
     using OrdStorage::getItemsCount;
     using OrdStorage::getRegister;
@@ -29,15 +35,74 @@ class SingleFileIndexedStorage : public IndexedStorage<T, IndexT, RegisterInfo>
      * @param storageFilePath Path of the storage file.
      * @param fileManager Shared access to the file manager.
      * @param registerSupplier Register supplier.
+     * @param appendBufferBytes Size of in-memory buffer of appended items. If buffer is exceeded,
+     * all buffered items are written to the file. If @p 0, every item is written as soon as it is appended.
      */
     explicit SingleFileIndexedStorage(const std::filesystem::path &storageFilePath,
                                       std::shared_ptr<io::FileManager> fileManager,
-                                      InnerRegisterSupplier registerSupplier)
+                                      InnerRegisterSupplier registerSupplier,
+                                      std::size_t appendBufferBytes = 0)
         : IndexedStorage<T, IndexT, RegisterInfo>(std::move(registerSupplier)),
-          storageFile_(std::make_shared<io::TemporaryFile>(storageFilePath, std::move(fileManager))) {
+          storageFile_(std::make_shared<io::TemporaryFile>(storageFilePath, std::move(fileManager))),
+          appendBufferItems_(appendBufferBytes / EACH_SIZE) {
         storageFile_->getFileManager()->create(storageFilePath);
     }
 
+    /**
+     * @brief Opens storage over the existing file. If file contains more than @p itemsCount items,
+     * which may happen if items were appended after the storage state was saved, the rest is cut off.
+     * @param storageFilePath Path of the storage file.
+     * @param fileManager Shared access to the file manager.
+     * @param itemsCount Number of items in the storage.
+     * @param innerRegister Register, which has already registered all items of the storage.
+     * @param appendBufferBytes Size of in-memory buffer of appended items.
+     * @throws FileException if file contains less than @p itemsCount items.
+     */
+    explicit SingleFileIndexedStorage(const std::filesystem::path &storageFilePath,
+                                      std::shared_ptr<io::FileManager> fileManager,
+                                      IndexT itemsCount,
+                                      std::unique_ptr<InnerRegister> &&innerRegister,
+                                      std::size_t appendBufferBytes = 0)
+        : IndexedStorage<T, IndexT, RegisterInfo>(itemsCount, std::move(innerRegister)),
+          storageFile_(std::make_shared<io::TemporaryFile>(storageFilePath, std::move(fileManager), false)),
+          appendBufferItems_(appendBufferBytes / EACH_SIZE) {
+        const std::uint64_t expectedSize = static_cast<std::uint64_t>(itemsCount) * EACH_SIZE;
+        const std::uint64_t fileSize = getFileManager()->getInputStream(storageFilePath, 0)->availableBytes();
+        if (fileSize < expectedSize) {
+            throw FileException(storageFilePath, "Expected to contain " + std::to_string(itemsCount) + " items");
+        }
+        if (fileSize > expectedSize) {
+            getFileManager()->truncate(storageFilePath, expectedSize);
+        }
+    }
+
+    /**
+     * @brief Creates storage which shares storage file with @p other.
+     * @p other must be flushed.
+     */
+    SingleFileIndexedStorage(const SingleFileIndexedStorage &other)
+        : IndexedStorage<T, IndexT, RegisterInfo>(other),
+          storageFile_(other.storageFile_),
+          appendBufferItems_(other.appendBufferItems_) {
+        assert(other.isFlushed());
+    }
+
+    SingleFileIndexedStorage(SingleFileIndexedStorage &&) = default;
+
+    SingleFileIndexedStorage &operator=(const SingleFileIndexedStorage &other) {
+        if (this != &other) {
+            assert(other.isFlushed());
+            flush();
+            IndexedStorage<T, IndexT, RegisterInfo>::operator=(other);
+            storageFile_ = other.storageFile_;
+            writer_.reset();
+            appendBufferItems_ = other.appendBufferItems_;
+        }
+        return *this;
+    }
+
+    SingleFileIndexedStorage &operator=(SingleFileIndexedStorage &&) = default;
+
     /**
      * @return Path of the file, associated with this storage.
      */
@@ -53,9 +118,10 @@ class SingleFileIndexedStorage : public IndexedStorage<T, IndexT, RegisterInfo>
     }
 
     /**
-     * @return The file, associated with this storage.
+     * @return The file, associated with this storage. Storage must be flushed.
      */
-    [[nodiscard]] std::shared_ptr<io::TemporaryFile> shareStorageFile() const noexcept {
+    [[nodiscard]] std::shared_ptr<io::TemporaryFile> shareStorageFile() const {
+        assert(isFlushed());
         return storageFile_;
     }
 
@@ -65,6 +131,10 @@ class SingleFileIndexedStorage : public IndexedStorage<T, IndexT, RegisterInfo>
      * @param other Storage to reset with.
      */
     virtual void resetWith(SingleFileIndexedStorage<T, IndexT, RegisterInfo> &&other) noexcept {
+        flush();
+        other.flush();
+        writer_.reset();
+        other.writer_.reset();
         getRegister() = std::move(other.getRegister());
         auto thisFileManager = getFileManager();
         assert(other.getFileManager() == thisFileManager);
@@ -77,10 +147,32 @@ class SingleFileIndexedStorage : public IndexedStorage<T, IndexT, RegisterInfo>
      * @return Index of added item in this storage.
      */
     void append(std::unique_ptr<T> &&item) override {
-        io::OutputIterator<T> writer = getFileManager()->template getOutputIterator<T>(getStorageFilePath(), true);
-        writer.write(*item);
-        writer.flush();
         getRegister().registerItem(*item);
+        appendBuffer_.push_back(std::move(*item));
+        if (appendBuffer_.size() > appendBufferItems_) {
+            flush();
+        }
+    }
+
+    /**
+     * @brief Writes all buffered items to the storage file, so that they become
+     * visible to everyone who reads the file.
+     */
+    void flush() {
+        if (appendBuffer_.empty()) {
+            return;
+        }
+        io::OutputIterator<T> &writer = getWriter();
+        writer.writeAll(appendBuffer_.begin(), appendBuffer_.end(), [](const T &item) { return item; });
+        writer.flush();
+        appendBuffer_.clear();
+    }
+
+    /**
+     * @return @p true if there are no buffered items, so the storage file contains all of them.
+     */
+    [[nodiscard]] bool isFlushed() const noexcept {
+        return appendBuffer_.empty();
     }
 
     /**
@@ -99,8 +191,8 @@ class SingleFileIndexedStorage : public IndexedStorage<T, IndexT, RegisterInfo>
         typename = std::enable_if_t<std::is_same_v<Result, T>>
     >
     void appendAll(IteratorT begin, IteratorT end, Functor func) {
-        io::OutputIterator<Result> writer
-            = getFileManager()->template getOutputIterator<Result>(getStorageFilePath(), true);
+        flush();
+        io::OutputIterator<Result> &writer = getWriter();
         writer.writeAll(begin, end, [&](const auto &obj) {
             auto fObj = func(obj);
             getRegister().registerItem(fObj);
@@ -128,29 +220,71 @@ class SingleFileIndexedStorage : public IndexedStorage<T, IndexT, RegisterInfo>
      */
     [[nodiscard]] T get(IndexT index) const override {
         assert(index < getItemsCount());
-        return getFileManager()->template getInputIterator<T, IndexT>(
-            getStorageFilePath(),
-            index * io::FixedDeserializedSizeRegister<T>::exactDeserializedSize
-        ).next();
+        IndexT writtenCount = getItemsCount() - appendBuffer_.size();
+        if (index >= writtenCount) {
+            return appendBuffer_[index - writtenCount];
+        }
+        std::array<char, EACH_SIZE> buffer;
+        getFileManager()->readAt(getStorageFilePath(), index * EACH_SIZE, EACH_SIZE, buffer.data());
+        return io::deserializeFrom<T>(buffer.data());
     }
 
     /**
-     * @return Associated storage elements input iterator over type @p T.
+     * @brief Reads @p count consecutive elements starting from index @p from with a single read.
+     * Storage must be flushed.
+     * @param from Index of the first element.
+     * @param count Number of elements to read.
+     * @return Elements with indices in range [@p from, @p from + @p count).
+     */
+    [[nodiscard]] std::vector<T> getRange(IndexT from, IndexT count) const {
+        assert(from + count <= getItemsCount());
+        assert(isFlushed());
+        std::vector<char> buffer(count * EACH_SIZE);
+        getFileManager()->readAt(getStorageFilePath(), from * EACH_SIZE, buffer.size(), buffer.data());
+        std::vector<T> items;
+        items.reserve(count);
+        for (IndexT i = 0; i < count; ++i) {
+            items.push_back(io::deserializeFrom<T>(buffer.data() + i * EACH_SIZE));
+        }
+        return items;
+    }
+
+    /**
+     * @return Associated storage elements input iterator over type @p T. Storage must be flushed.
      */
     io::InputIterator<T, IndexT> getDataIterator() const {
+        assert(isFlushed());
         return getFileManager()->template getInputIterator<T, IndexT>(getStorageFilePath(), 0);
     }
 
     /**
-     * @return Associated storage elements input iterator over type @p Out.
+     * @return Associated storage elements input iterator over type @p Out. Storage must be flushed.
      */
     template <typename Out>
     io::InputIterator<Out, IndexT> getCustomDataIterator() const {
+        assert(isFlushed());
         return io::InputIterator<Out, IndexT>(getFileManager()->getInputStream(getStorageFilePath(), 0));
     }
 
   protected:
+    static constexpr std::size_t EACH_SIZE = io::FixedDeserializedSizeRegister<T>::exactDeserializedSize;
+
+    /**
+     * @return Writer, which appends to the storage file. It is opened once and kept open.
+     */
+    io::OutputIterator<T> &getWriter() {
+        if (!writer_) {
+            writer_ = std::make_unique<io::OutputIterator<T>>(
+                getFileManager()->template getOutputIterator<T>(getStorageFilePath(), true)
+            );
+        }
+        return *writer_;
+    }
+
     std::shared_ptr<io::TemporaryFile> storageFile_;
+    std::unique_ptr<io::OutputIterator<T>> writer_;
+    std::vector<T> appendBuffer_;
+    std::size_t appendBufferItems_;
 };
 
 } // supermap
@@ -0,0 +1,277 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include "Arena.hpp"
+#include "ExtractibleKeyValueStorage.hpp"
+
+namespace supermap {
+
+/**
+ * @brief Skiplist, which nodes are allocated from the arena, so that inserts do not touch the heap,
+ * and the whole skiplist is freed at once.
+ * It can be modified by one thread, while any number of other threads read it without locks:
+ * new nodes and values are published with release stores, and memory of nodes is never reused
+ * until the skiplist is cleared. Replaced values and removed nodes are retired, and destroyed
+ * only on clearing. Extraction and clearing require that no one reads the skiplist.
+ * @tparam Key key type.
+ * @tparam Value value type.
+ * @tparam IndexT storage index type.
+ */
+template <typename Key, typename Value, typename IndexT>
+class SkipList : public ExtractibleKeyValueStorage<Key, Value, IndexT> {
+  private:
+    /**
+     * @brief Values, which can be atomically replaced in place. Other values are allocated
+     * in the arena, and replaced by the pointer.
+     */
+    static constexpr bool isInlineValue() {
+        if constexpr (std::is_trivially_copyable_v<Value>) {
+            return std::atomic<Value>::is_always_lock_free;
+        } else {
+            return false;
+        }
+    }
+
+    static constexpr bool INLINE_VALUE = isInlineValue();
+
+    static constexpr bool TRIVIALLY_DESTRUCTIBLE =
+        std::is_trivially_destructible_v<Key> && std::is_trivially_destructible_v<Value>;
+
+    using ValueCell = std::conditional_t<INLINE_VALUE, std::atomic<Value>, std::atomic<const Value *>>;
+
+    struct Node {
+        Node(const Key &key_, std::atomic<Node *> *next_) : key(key_), next(next_) {}
+
+        const Key key;
+        ValueCell value{};
+        std::atomic<Node *> *const next;
+    };
+
+  public:
+    /**
+     * @brief The largest height of the node.
+     */
+    static constexpr std::size_t MAX_HEIGHT = 12;
+
+    /**
+     * @brief Every node of height h has height at least h + 1 with probability 1 / BRANCHING.
+     */
+    static constexpr std::uint32_t BRANCHING = 4;
+
+    SkipList() = default;
+
+    SkipList(const SkipList &) = delete;
+    SkipList &operator=(const SkipList &) = delete;
+
+    ~SkipList() override {
+        clear();
+    }
+
+    /**
+     * @brief Add key-value pair to the skiplist, replacing the value, if @p key is already there.
+     * @param key Key to add.
+     * @param value Value to add.
+     */
+    void add(const Key &key, Value &&value) override {
+        std::array<std::atomic<Node *> *, MAX_HEIGHT> links{};
+        Node *found = findGreaterOrEqual(key, links.data());
+        if (found != nullptr && found->key == key) {
+            storeValue(*found, std::move(value));
+            return;
+        }
+        std::size_t height = getRandomHeight();
+        auto *next = static_cast<std::atomic<Node *> *>(
+            arena_.allocate(height * sizeof(std::atomic<Node *>), alignof(std::atomic<Node *>)));
+        for (std::size_t level = 0; level < height; ++level) {
+            new(next + level) std::atomic<Node *>(links[level]->load(std::memory_order_relaxed));
+        }
+        Node *node = arena_.create<Node>(key, next);
+        storeValue(*node, std::move(value));
+        for (std::size_t level = 0; level < height; ++level) {
+            links[level]->store(node, std::memory_order_release);
+        }
+        size_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @return The most relevant @p Value associated with @p key.
+     */
+    std::optional<Value> getValue(const Key &key) override {
+        const Node *found = findGreaterOrEqual(key, nullptr);
+        if (found == nullptr || !(found->key == key)) {
+            return std::nullopt;
+        }
+        return loadValue(*found);
+    }
+
+    /**
+     * @return Current number of keys in the skiplist.
+     */
+    IndexT getUpperSizeBound() const override {
+        return static_cast<IndexT>(size_.load(std::memory_order_relaxed));
+    }
+
+    /**
+     * @brief Unlinks @p key from the skiplist. Its node is freed only with the whole skiplist,
+     * so readers, which have already reached it, can still read it.
+     */
+    void remove(const Key &key) override {
+        std::array<std::atomic<Node *> *, MAX_HEIGHT> links{};
+        Node *found = findGreaterOrEqual(key, links.data());
+        if (found == nullptr || !(found->key == key)) {
+            return;
+        }
+        for (std::size_t level = 0; level < MAX_HEIGHT && links[level]->load(std::memory_order_relaxed) == found;
+             ++level) {
+            links[level]->store(found->next[level].load(std::memory_order_relaxed), std::memory_order_release);
+        }
+        if constexpr (!TRIVIALLY_DESTRUCTIBLE) {
+            retiredNodes_.push_back(found);
+        }
+        size_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Move all key-value pairs to the vector, emptying the skiplist.
+     */
+    std::vector<KeyValue<Key, Value>> extract() && override {
+        std::vector<KeyValue<Key, Value>> extracted;
+        extracted.reserve(size_.load(std::memory_order_relaxed));
+        std::move(*this).extractSorted([&extracted](const KeyValue<Key, Value> &kv) {
+            extracted.push_back(kv);
+        });
+        return extracted;
+    }
+
+    /**
+     * @brief Walks the skiplist in key order, passing every pair to @p consumer, then frees it at once.
+     */
+    void extractSorted(const std::function<void(const KeyValue<Key, Value> &)> &consumer) && override {
+        forEachSorted(consumer);
+        clear();
+    }
+
+    /**
+     * @brief Walks the skiplist in key order, passing every pair to @p consumer.
+     * May be called concurrently with modifications as well.
+     */
+    void forEachSorted(const std::function<void(const KeyValue<Key, Value> &)> &consumer) const override {
+        for (const Node *node = head_[0].load(std::memory_order_acquire);
+             node != nullptr;
+             node = node->next[0].load(std::memory_order_acquire)) {
+            consumer(KeyValue<Key, Value>(node->key, loadValue(*node)));
+        }
+    }
+
+    std::unique_ptr<ExtractibleKeyValueStorage<Key, Value, IndexT>> createLikeThis() const override {
+        return std::make_unique<SkipList<Key, Value, IndexT>>();
+    }
+
+    /**
+     * @return Number of bytes, taken by the skiplist arena from the heap.
+     */
+    [[nodiscard]] std::size_t getMemoryUsage() const noexcept {
+        return arena_.getMemoryUsage();
+    }
+
+  private:
+    /**
+     * @brief Finds the first node with key not less than @p key.
+     * @param key Key to find.
+     * @param links If not @p nullptr, links to the found node from its predecessors on each level are written there.
+     * @return Found node, or @p nullptr if all keys are less than @p key.
+     */
+    Node *findGreaterOrEqual(const Key &key, std::atomic<Node *> **links) const {
+        std::atomic<Node *> *level = head_.data();
+        Node *next = nullptr;
+        for (std::size_t i = MAX_HEIGHT; i-- > 0;) {
+            next = level[i].load(std::memory_order_acquire);
+            while (next != nullptr && next->key < key) {
+                level = next->next;
+                next = level[i].load(std::memory_order_acquire);
+            }
+            if (links != nullptr) {
+                links[i] = level + i;
+            }
+        }
+        return next;
+    }
+
+    std::size_t getRandomHeight() {
+        std::size_t height = 1;
+        while (height < MAX_HEIGHT && random_() % BRANCHING == 0) {
+            ++height;
+        }
+        return height;
+    }
+
+    void storeValue(Node &node, Value &&value) {
+        if constexpr (INLINE_VALUE) {
+            node.value.store(value, std::memory_order_release);
+        } else {
+            const Value *replaced = node.value.exchange(arena_.create<Value>(std::move(value)),
+                                                        std::memory_order_acq_rel);
+            if constexpr (!std::is_trivially_destructible_v<Value>) {
+                if (replaced != nullptr) {
+                    retiredValues_.push_back(replaced);
+                }
+            }
+        }
+    }
+
+    static Value loadValue(const Node &node) {
+        if constexpr (INLINE_VALUE) {
+            return node.value.load(std::memory_order_acquire);
+        } else {
+            return *node.value.load(std::memory_order_acquire);
+        }
+    }
+
+    /**
+     * @brief Empties the skiplist and frees its arena.
+     */
+    void clear() {
+        if constexpr (!TRIVIALLY_DESTRUCTIBLE) {
+            for (Node *node = head_[0].load(std::memory_order_relaxed); node != nullptr;) {
+                Node *next = node->next[0].load(std::memory_order_relaxed);
+                destroy(node);
+                node = next;
+            }
+            for (Node *node : retiredNodes_) {
+                destroy(node);
+            }
+            for (const Value *value : retiredValues_) {
+                value->~Value();
+            }
+            retiredNodes_.clear();
+            retiredValues_.clear();
+        }
+        for (auto &link : head_) {
+            link.store(nullptr, std::memory_order_relaxed);
+        }
+        size_.store(0, std::memory_order_relaxed);
+        arena_.clear();
+    }
+
+    static void destroy(Node *node) {
+        if constexpr (!INLINE_VALUE) {
+            node->value.load(std::memory_order_relaxed)->~Value();
+        }
+        node->~Node();
+    }
+
+    mutable std::array<std::atomic<Node *>, MAX_HEIGHT> head_{};
+    std::atomic<std::size_t> size_ = 0;
+    Arena arena_;
+    std::vector<Node *> retiredNodes_;
+    std::vector<const Value *> retiredValues_;
+    std::minstd_rand random_{std::random_device{}()};
+};
+
+} // supermap
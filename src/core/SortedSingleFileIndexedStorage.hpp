@@ -1,6 +1,8 @@
 #pragma once
 
 #include <algorithm>
+#include <iterator>
+#include <vector>
 
 #include "SingleFileIndexedStorage.hpp"
 #include "Findable.hpp"
@@ -9,7 +11,8 @@ namespace supermap {
 
 /**
  * @brief Single file storage where objects are sorted in increasing order,
- * defined by comparator.
+ * defined by comparator. Keeps every @p FENCE_STEP object in RAM as a fence,
+ * so that search reads only one block of objects between two neighbour fences.
  * @tparam T Stored objects type.
  * @tparam IndexT Storage index type.
  * @tparam RegisterInfo Inner register info type.
@@ -23,14 +26,33 @@ template <
 class SortedSingleFileIndexedStorage : public SingleFileIndexedStorage<T, IndexT, RegisterInfo>,
                                        public Findable<T, FindPattern> {
   public:
-    using SingleFileIndexedStorage<T, IndexT, RegisterInfo>::getItemsCount;
-    using SingleFileIndexedStorage<T, IndexT, RegisterInfo>::get;
-    using SingleFileIndexedStorage<T, IndexT, RegisterInfo>::append;
-    using SingleFileIndexedStorage<T, IndexT, RegisterInfo>::appendAll;
-    using SingleFileIndexedStorage<T, IndexT, RegisterInfo>::SingleFileIndexedStorage;
+    using StorageBase = SingleFileIndexedStorage<T, IndexT, RegisterInfo>;
+    using StorageBase::getItemsCount;
+    using StorageBase::get;
+    using StorageBase::getRange;
+    using StorageBase::getFileManager;
+    using StorageBase::getStorageFilePath;
+    using StorageBase::SingleFileIndexedStorage;
     using OrderedStorage<T, IndexT, RegisterInfo>::getRegister;
     using InnerRegisterSupplier = typename SingleFileIndexedStorage<T, IndexT, RegisterInfo>::InnerRegisterSupplier;
 
+    /**
+     * @brief Number of objects between two neighbour fences, so that they take about one disk block.
+     */
+    static constexpr std::size_t FENCE_STEP
+        = std::max<std::size_t>(1, 4096 / io::FixedDeserializedSizeRegister<T>::exactDeserializedSize);
+
+    /**
+     * @brief Fences are kept only if they take at most 1/8 of the storage file, otherwise
+     * objects are too big and search falls back to binary search over the file.
+     */
+    static constexpr bool HAS_FENCES = FENCE_STEP >= 8;
+
+    /**
+     * @brief Number of objects, which are written at once, when storage is created from the producer.
+     */
+    static constexpr std::size_t PRODUCED_CHUNK_ITEMS = 4096;
+
     /**
      * @brief Creates new sorted storage from objects collection.
      * @tparam Iterator Collections iterator type.
@@ -61,7 +83,81 @@ class SortedSingleFileIndexedStorage : public SingleFileIndexedStorage<T, IndexT
                                                           manager,
                                                           std::move(registerSupplier)) {
         getRegister().reserve(std::distance(begin, end) + 1);
+        if constexpr (HAS_FENCES) {
+            fences_.reserve(std::distance(begin, end) / FENCE_STEP + 1);
+        }
         appendAll(begin, sorted ? end : sortedEndIterator(begin, end, isLess, isEq));
+        seal();
+    }
+
+    /**
+     * @brief Creates new sorted storage from objects, which are produced one by one in sorted order.
+     * They are written to the file by chunks of @p PRODUCED_CHUNK_ITEMS objects, so they are never
+     * collected in memory all together.
+     * @param count Upper bound of the number of produced objects.
+     * @param producer Function, which passes all objects in sorted order to the given consumer.
+     * @param dataFileName File where storage will take place.
+     * @param manager Shared access to the file manager.
+     * @param registerSupplier Supplier of the storage item register.
+     */
+    explicit SortedSingleFileIndexedStorage(IndexT count,
+                                            const std::function<void(const std::function<void(const T &)> &)> &producer,
+                                            std::string dataFileName,
+                                            std::shared_ptr<io::FileManager> manager,
+                                            InnerRegisterSupplier registerSupplier
+    ) : SingleFileIndexedStorage<T, IndexT, RegisterInfo>(std::move(dataFileName),
+                                                          manager,
+                                                          std::move(registerSupplier)) {
+        getRegister().reserve(count + 1);
+        if constexpr (HAS_FENCES) {
+            fences_.reserve(count / FENCE_STEP + 1);
+        }
+        std::vector<T> chunk;
+        chunk.reserve(std::min<std::size_t>(count, PRODUCED_CHUNK_ITEMS));
+        producer([&](const T &item) {
+            chunk.push_back(item);
+            if (chunk.size() == PRODUCED_CHUNK_ITEMS) {
+                appendAll(chunk.begin(), chunk.end());
+                chunk.clear();
+            }
+        });
+        appendAll(chunk.begin(), chunk.end());
+        seal();
+    }
+
+    /**
+     * @brief Opens sorted storage over the existing file.
+     * @param storageFilePath Path of the storage file.
+     * @param fileManager Shared access to the file manager.
+     * @param itemsCount Number of items in the storage.
+     * @param innerRegister Register, which has already registered all items of the storage.
+     * @param fences Fences of the storage, as they were returned by @p getFences.
+     */
+    explicit SortedSingleFileIndexedStorage(const std::filesystem::path &storageFilePath,
+                                            std::shared_ptr<io::FileManager> fileManager,
+                                            IndexT itemsCount,
+                                            std::unique_ptr<typename StorageBase::InnerRegister> &&innerRegister,
+                                            std::vector<T> fences)
+        : StorageBase(storageFilePath, std::move(fileManager), itemsCount, std::move(innerRegister)),
+          fences_(std::move(fences)) {
+        getFileManager()->seal(getStorageFilePath());
+    }
+
+    /**
+     * @brief Marks storage as complete: seals its register, and tells the file manager
+     * that the storage file will only be read from now on.
+     */
+    void seal() {
+        StorageBase::flush();
+        getRegister().seal();
+        getFileManager()->seal(getStorageFilePath());
+    }
+
+    /**
+     * @return Every @p FENCE_STEP -th item of the storage, which is kept in RAM.
+     */
+    [[nodiscard]] const std::vector<T> &getFences() const noexcept {
+        return fences_;
     }
 
     /**
@@ -112,24 +208,161 @@ class SortedSingleFileIndexedStorage : public SingleFileIndexedStorage<T, IndexT
         if (getItemsCount() == 0) {
             return std::nullopt;
         }
+        auto isLeq = [&](const T &item) { return less(item, pattern) || equal(item, pattern); };
+        if (hasActualFences()) {
+            auto fenceIt = std::partition_point(fences_.begin(), fences_.end(), isLeq);
+            if (fenceIt == fences_.begin()) {
+                return std::nullopt;
+            }
+            std::size_t from = (fenceIt - fences_.begin() - 1) * FENCE_STEP;
+            std::size_t windowSize = std::min<std::size_t>(FENCE_STEP, getItemsCount() - from);
+            std::vector<T> window = getRange(static_cast<IndexT>(from), static_cast<IndexT>(windowSize));
+            auto lastLeq = std::prev(std::partition_point(window.begin(), window.end(), isLeq));
+            return equal(*lastLeq, pattern) ? std::optional{std::move(*lastLeq)} : std::nullopt;
+        }
         IndexT firstLeq = 0;
         IndexT lastGt = getItemsCount();
         while (lastGt - firstLeq > 1) {
             IndexT middle = (firstLeq + lastGt) / 2;
-            T middleElem = get(middle);
-            if (less(middleElem, pattern) || equal(middleElem, pattern)) {
+            if (isLeq(get(middle))) {
                 firstLeq = middle;
             } else {
                 lastGt = middle;
             }
         }
-        if (firstLeq >= getItemsCount()) {
-            return std::nullopt;
-        }
         T firstLeqElem = get(firstLeq);
         return equal(firstLeqElem, pattern) ? std::optional{firstLeqElem} : std::nullopt;
     }
 
+    /**
+     * @brief Searches for sorted @p patterns in one pass: search of every pattern starts from the position,
+     * where the previous one was found, and the block between two fences is read only once
+     * for all patterns, which fall into it.
+     * @param patterns Find patterns, ordered by @p less.
+     * @param less Predicate, accepts object from storage and pattern, returns if object is less then pattern.
+     * @param equal Predicate, accepts object from storage and pattern, returns if this is equals to pattern.
+     * @return Results of @p find for every pattern, in the same order.
+     */
+    std::vector<std::optional<T>> findAll(
+        const std::vector<FindPattern> &patterns,
+        const std::vector<hashTools::KeyHash> *,
+        std::function<bool(const T &, const FindPattern &)> less,
+        std::function<bool(const T &, const FindPattern &)> equal
+    ) override {
+        std::vector<std::optional<T>> found(patterns.size());
+        if (getItemsCount() == 0) {
+            return found;
+        }
+        IndexT firstLeq = 0;
+        std::size_t firstLeqFence = 0;
+        std::optional<std::size_t> windowFence;
+        std::vector<T> window;
+        for (std::size_t i = 0; i < patterns.size(); ++i) {
+            const FindPattern &pattern = patterns[i];
+            auto isLeq = [&](const T &item) { return less(item, pattern) || equal(item, pattern); };
+            if (hasActualFences()) {
+                auto fenceIt = std::partition_point(fences_.begin() + firstLeqFence, fences_.end(), isLeq);
+                if (fenceIt == fences_.begin()) {
+                    continue;
+                }
+                firstLeqFence = fenceIt - fences_.begin() - 1;
+                if (windowFence != firstLeqFence) {
+                    std::size_t from = firstLeqFence * FENCE_STEP;
+                    std::size_t windowSize = std::min<std::size_t>(FENCE_STEP, getItemsCount() - from);
+                    window = getRange(static_cast<IndexT>(from), static_cast<IndexT>(windowSize));
+                    windowFence = firstLeqFence;
+                }
+                auto lastLeq = std::prev(std::partition_point(window.begin(), window.end(), isLeq));
+                if (equal(*lastLeq, pattern)) {
+                    found[i] = *lastLeq;
+                }
+                continue;
+            }
+            IndexT lastGt = getItemsCount();
+            while (lastGt - firstLeq > 1) {
+                IndexT middle = (firstLeq + lastGt) / 2;
+                if (isLeq(get(middle))) {
+                    firstLeq = middle;
+                } else {
+                    lastGt = middle;
+                }
+            }
+            T firstLeqElem = get(firstLeq);
+            if (equal(firstLeqElem, pattern)) {
+                found[i] = std::move(firstLeqElem);
+            }
+        }
+        return found;
+    }
+
+    /**
+     * @brief Appends an item to the end of storage, remembering it as a fence if needed.
+     * Items must be appended in sorted order.
+     * @param item New object to be added.
+     */
+    void append(std::unique_ptr<T> &&item) override {
+        if (HAS_FENCES && static_cast<std::size_t>(getItemsCount()) % FENCE_STEP == 0) {
+            fences_.push_back(*item);
+        }
+        StorageBase::append(std::move(item));
+    }
+
+    /**
+     * @brief Appends all items from @p begin to the @p end to this storage, remembering fences.
+     * Items must be appended in sorted order.
+     * @tparam IteratorT Type of iterator.
+     * @tparam Functor Type of @p func.
+     * @tparam Result Type of @p func application to the @p *it. Must be the same as @p T.
+     * @param begin Collection begin iterator.
+     * @param end Collections end iterator.
+     * @param func Functor which is applied to the every item in collection.
+     */
+    template <
+        typename IteratorT,
+        typename Functor,
+        typename Result = std::invoke_result_t<Functor, typename std::iterator_traits<IteratorT>::value_type>,
+        typename = std::enable_if_t<std::is_same_v<Result, T>>
+    >
+    void appendAll(IteratorT begin, IteratorT end, Functor func) {
+        std::size_t index = getItemsCount();
+        StorageBase::appendAll(begin, end, [&](const auto &obj) {
+            T fObj = func(obj);
+            if (HAS_FENCES && index++ % FENCE_STEP == 0) {
+                fences_.push_back(fObj);
+            }
+            return fObj;
+        });
+    }
+
+    /**
+     * @brief Appends all items from @p begin to the @p end, remembering fences.
+     * Items must be appended in sorted order.
+     * @tparam IteratorT Iterator type.
+     * @param begin Collection begin iterator.
+     * @param end Collection end iterator.
+     */
+    template <
+        typename IteratorT,
+        typename = std::enable_if_t<std::is_same_v<T, typename std::iterator_traits<IteratorT>::value_type>>
+    >
+    void appendAll(IteratorT begin, IteratorT end) {
+        appendAll(begin, end, [](auto x) { return x; });
+    }
+
+    /**
+     * @brief Resets this storage with other, taking its fences if it is sorted storage as well.
+     * @param other Storage to reset with.
+     */
+    void resetWith(StorageBase &&other) noexcept override {
+        StorageBase::resetWith(std::move(other));
+        auto *sortedOther = dynamic_cast<SortedSingleFileIndexedStorage *>(&other);
+        if (sortedOther) {
+            std::swap(fences_, sortedOther->fences_);
+        } else {
+            fences_.clear();
+        }
+    }
+
     /**
      * @brief Creates merged sorted storage from all @p newer sorted storages.
      * @param newer Sorted storages, which are ordered from least to the most relevant.
@@ -150,22 +383,41 @@ class SortedSingleFileIndexedStorage : public SingleFileIndexedStorage<T, IndexT
         std::move(fileManager),
         std::move(registerSupplier)
     ) {
-        const std::size_t storagesCount = newer.size();
-        std::vector<IndexT> currentFrontPointers(storagesCount);
-        std::vector<std::optional<T>> frontLine(storagesCount, std::nullopt);
+        std::vector<MergeSource> sources;
+        sources.reserve(newer.size());
         std::uint64_t totalSize = 0;
-        for (std::size_t i = 0; i < storagesCount; ++i) {
-            if (newer[i].getItemsCount() > 0) {
-                frontLine[i].emplace(newer[i].get(0));
-                totalSize += newer[i].getItemsCount();
-            }
+        const IndexT readBatchSize = std::max<IndexT>(1, batchSize / std::max<std::size_t>(1, newer.size()));
+        for (const auto &storage : newer) {
+            totalSize += storage.getItemsCount();
+            sources.emplace_back(storage.getDataIterator(), storage.getItemsCount(), readBatchSize);
         }
         getRegister().reserve(totalSize);
-        auto updateOnce = [&](std::int32_t i) {
-            if (++currentFrontPointers[i] < newer[i].getItemsCount()) {
-                frontLine[i].emplace(newer[i].get(currentFrontPointers[i]));
+        if constexpr (HAS_FENCES) {
+            fences_.reserve(totalSize / FENCE_STEP + 1);
+        }
+
+        // Heap of sources, where the source with the least front item is on top.
+        // If front items are equal, the more relevant source (one with greater index) goes first.
+        auto isLessPrior = [&sources](std::size_t a, std::size_t b) {
+            const T &aFront = sources[a].front();
+            const T &bFront = sources[b].front();
+            return bFront < aFront || (aFront == bFront && a < b);
+        };
+        std::vector<std::size_t> heap;
+        heap.reserve(sources.size());
+        for (std::size_t i = 0; i < sources.size(); ++i) {
+            if (!sources[i].empty()) {
+                heap.push_back(i);
+            }
+        }
+        std::make_heap(heap.begin(), heap.end(), isLessPrior);
+        auto popAndAdvance = [&]() {
+            std::pop_heap(heap.begin(), heap.end(), isLessPrior);
+            std::size_t source = heap.back();
+            if (sources[source].advance()) {
+                std::push_heap(heap.begin(), heap.end(), isLessPrior);
             } else {
-                frontLine[i].reset();
+                heap.pop_back();
             }
         };
 
@@ -175,39 +427,80 @@ class SortedSingleFileIndexedStorage : public SingleFileIndexedStorage<T, IndexT
         auto dropWriteBuffer = [&]() {
             appendAll(writeBuffer.begin(), writeBuffer.end());
             writeBuffer.clear();
-            writeBuffer.reserve(batchSize);
         };
 
-        while (true) {
-            std::size_t min = 0;
-            bool hasMin = false;
-            for (std::int32_t i = storagesCount - 1; i >= 0; --i) {
-                if (!frontLine[i].has_value()) {
-                    continue;
-                }
-                if (!hasMin) {
-                    hasMin = true;
-                    min = i;
-                    continue;
-                }
-                if (frontLine[i].value() < frontLine[min].value()) {
-                    min = i;
-                } else if (frontLine[i].value() == frontLine[min].value()) {
-                    updateOnce(i);
-                }
-            }
-            if (!hasMin) {
-                break;
+        while (!heap.empty()) {
+            T minItem = sources[heap.front()].front();
+            popAndAdvance();
+            while (!heap.empty() && sources[heap.front()].front() == minItem) {
+                popAndAdvance();
             }
-            T minItem = frontLine[min].value();
-            updateOnce(min);
             writeBuffer.push_back(std::move(minItem));
             if (static_cast<IndexT>(writeBuffer.size()) >= batchSize) {
                 dropWriteBuffer();
             }
         }
         dropWriteBuffer();
+        seal();
+    }
+
+  private:
+    /**
+     * @brief Sequential reader of one merged storage, which reads items by batches.
+     */
+    class MergeSource {
+      public:
+        MergeSource(io::InputIterator<T, IndexT> &&iterator, IndexT itemsCount, IndexT batchSize)
+            : iterator_(std::move(iterator)), remaining_(itemsCount), batchSize_(batchSize) {
+            readBatch();
+        }
+
+        [[nodiscard]] bool empty() const noexcept {
+            return position_ >= batch_.size();
+        }
+
+        [[nodiscard]] const T &front() const {
+            return batch_[position_];
+        }
+
+        /**
+         * @brief Moves to the next item, reading the next batch if needed.
+         * @return If there is next item.
+         */
+        bool advance() {
+            if (++position_ >= batch_.size()) {
+                readBatch();
+            }
+            return !empty();
+        }
+
+      private:
+        void readBatch() {
+            batch_.clear();
+            position_ = 0;
+            if (remaining_ > 0) {
+                batch_ = iterator_.collect(std::min(remaining_, batchSize_));
+                remaining_ -= static_cast<IndexT>(batch_.size());
+            }
+        }
+
+        io::InputIterator<T, IndexT> iterator_;
+        IndexT remaining_;
+        IndexT batchSize_;
+        std::vector<T> batch_;
+        std::size_t position_ = 0;
+    };
+
+    /**
+     * @return If fences cover all items of this storage. Not so if file contents
+     * were replaced not by this storage, then search does not use fences.
+     */
+    [[nodiscard]] bool hasActualFences() const {
+        return HAS_FENCES
+            && fences_.size() == (static_cast<std::size_t>(getItemsCount()) + FENCE_STEP - 1) / FENCE_STEP;
     }
+
+    std::vector<T> fences_;
 };
 
 } // supermap
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include "SortedSingleFileIndexedStorage.hpp"
 
 namespace supermap {
@@ -33,6 +36,11 @@ class SortedStoragesList
 
     SortedStoragesList()
         : OrderedStorage<SortedStorage, IndexT, void>([]() { return std::make_unique<StoragesRegister>(); }) {}
+
+    /**
+     * @return All storages of the list, ordered from the most to the least relevant.
+     */
+    virtual std::vector<std::shared_ptr<SortedStorage>> getStorages() = 0;
 };
 
 } // supermap
@@ -31,6 +31,11 @@ class StorageItemRegister : public Cloneable<StorageItemRegister<T, Info>> {
      */
     virtual void reserve(std::uint64_t) {}
 
+    /**
+     * @brief Tells register that all storage items are registered.
+     */
+    virtual void seal() {}
+
     virtual ~StorageItemRegister() = default;
 };
 
@@ -1,7 +1,12 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <deque>
+#include <future>
 #include <memory>
+#include <numeric>
 #include <random>
 
 #include "KeyValueStorage.hpp"
@@ -11,6 +16,13 @@
 #include "BinaryCollapsingSortedStoragesList.hpp"
 #include "FilteringRegister.hpp"
 #include "FilteredStorage.hpp"
+#include "FilterPolicy.hpp"
+#include "LazyFilter.hpp"
+#include "Manifest.hpp"
+#include "io/WriteAheadLog.hpp"
+#include "io/PinningFileManager.hpp"
+#include "exception/IllegalArgumentException.hpp"
+#include "exception/IllegalStateException.hpp"
 
 namespace supermap {
 
@@ -18,6 +30,16 @@ namespace supermap {
  * @brief Key-value storage.
  * Stores all values on disk. The index is partially stored in RAM.
  * When the index in RAM overflows, it is reset to an index on disk, where it is stored as a binary collapsible list.
+ * Index in RAM may be flushed in background: then the full index is frozen as immutable, the new one
+ * is started, and lookups consult the immutable indices until their disk storages are appended to the disk index.
+ * When not sorted part of the data storage becomes too large, the storage is shrunk. Shrink may be done
+ * in background: then the current data storage and its index are frozen, new items are added to the
+ * next generation storage, and lookups consult both generations until the shrunk storage is swapped in.
+ * If write-ahead log is given, every added item is logged before it is added to the storage,
+ * and all items from the log are added to the storage during construction.
+ * Persistent storage saves its state to the @p Manifest on @p checkpoint and on destruction,
+ * and may be reopened from it. Filters of index storages are saved next to them, and are read on demand.
+ * Lookups do not modify the storage, so they may run concurrently with each other, but not with other methods.
  * @tparam Key Type of key.
  * @tparam Value Type of value.
  * @tparam IndexT Type of size.
@@ -41,15 +63,77 @@ class Supermap : public KeyValueStorage<Key, Value, IndexT> {
     using IndexStorageBase = SortedSingleFileIndexedStorage<KeyIndex, IndexT, RegisterInfo, Key>;
     using RamStorageBase = ExtractibleKeyValueStorage<Key, IndexT, IndexT>;
     using DiskStorage = KeyValueShrinkableStorage<Key, Value, IndexT, RegisterInfo>;
+    using ManifestType = Manifest<KeyIndex, IndexT>;
+
+    /**
+     * @brief Suffix of the file, where filter of index storage is saved.
+     */
+    static constexpr const char *FILTER_FILE_SUFFIX = ".filter";
+
+    /**
+     * @brief Memory and efficiency of index filters.
+     */
+    struct FilterStats {
+        /**
+         * @brief Filter of one index storage.
+         */
+        struct StorageFilter {
+            IndexT items;
+            std::uint64_t memoryBits;
+            double falsePositiveProbability;
+        };
+
+        /**
+         * @brief Filters of all index storages, in order they are checked by lookup.
+         */
+        std::vector<StorageFilter> storages;
+
+        /**
+         * @brief Total memory of all filters.
+         */
+        std::uint64_t memoryBits = 0;
+
+        /**
+         * @brief Expected number of index storages, which are searched on disk by lookup of the absent key.
+         */
+        double expectedFalsePositives = 0;
+    };
 
   public:
+    /**
+     * @brief Creates Supermap.
+     * @param innerStorage Index of the recently added items, which resides in RAM.
+     * @param diskDataStorage Storage of all items.
+     * @param keyIndexStorageSupplier Function which creates disk index storage from sorted storage.
+     * @param indexListSupplier Supplier of the disk index list.
+     * @param registerSupplier Supplier of the disk index storages registers.
+     * @param keyIndexBatchSize The largest size of an index that can reside in RAM.
+     * @param maxNotSortedPart Part of not sorted items in data storage, which triggers shrink.
+     * @param backgroundShrink If data storage is shrunk in background.
+     * @param writeAheadLog Log of added items, may be @p nullptr. It is cleared on checkpoint,
+     * so it requires storage to be persistent.
+     * @param persistentFileManager If not @p nullptr, storage is persistent: its files are managed
+     * by this manager, and the manifest is written to it.
+     * @param manifest Manifest to restore disk index from. Data storage must already be opened from it.
+     * @param filterPolicy Policy of index filters sizing, which is kept informed about the number of keys.
+     * @param maxImmutableMemtables If positive, full index in RAM is flushed in background, and adding waits
+     * for the flush only when more than this number of frozen indices are waiting for it.
+     * Index in RAM must support @p forEachSorted then.
+     * @throws IllegalArgumentException if @p writeAheadLog is given without @p persistentFileManager.
+     */
     explicit Supermap(std::unique_ptr<RamStorageBase> &&innerStorage,
                       std::unique_ptr<DiskStorage> &&diskDataStorage,
                       std::function<std::unique_ptr<IndexStorageBase>(IndexStorageBase &&)> keyIndexStorageSupplier,
                       std::function<std::unique_ptr<IndexStorageListBase>()> indexListSupplier,
                       std::function<std::unique_ptr<RegisterBase>()> registerSupplier,
                       IndexT keyIndexBatchSize,
-                      double maxNotSortedPart)
+                      double maxNotSortedPart,
+                      bool backgroundShrink = false,
+                      std::unique_ptr<io::WriteAheadLog<KeyVal>> writeAheadLog = nullptr,
+                      std::shared_ptr<io::PinningFileManager> persistentFileManager = nullptr,
+                      const std::optional<ManifestType> &manifest = std::nullopt,
+                      std::shared_ptr<FilterPolicy> filterPolicy = nullptr,
+                      std::size_t maxImmutableMemtables = 0)
         : innerStorage_(std::move(innerStorage)),
           diskDataStorage_(std::move(diskDataStorage)),
           diskIndex_(indexListSupplier()),
@@ -58,7 +142,28 @@ class Supermap : public KeyValueStorage<Key, Value, IndexT> {
           registerSupplier_(std::move(registerSupplier)),
           keyIndexBatchSize_(keyIndexBatchSize),
           random(std::chrono::steady_clock::now().time_since_epoch().count()),
-          maxNotSortedPart_(maxNotSortedPart) {}
+          maxNotSortedPart_(maxNotSortedPart),
+          backgroundShrink_(backgroundShrink),
+          writeAheadLog_(std::move(writeAheadLog)),
+          persistentFileManager_(std::move(persistentFileManager)),
+          filterPolicy_(std::move(filterPolicy)),
+          maxImmutableMemtables_(maxImmutableMemtables) {
+        if (writeAheadLog_ && !persistentFileManager_) {
+            throw IllegalArgumentException("Write-ahead log requires persistent storage");
+        }
+        updateFilterPolicy();
+        if (manifest.has_value()) {
+            for (auto it = manifest->indexStorages.rbegin(); it != manifest->indexStorages.rend(); ++it) {
+                diskIndex_->append(openIndexStorage(*it));
+            }
+            if (manifest->baseIndex.has_value()) {
+                baseIndex_ = openIndexStorage(manifest->baseIndex.value());
+            }
+        }
+        if (writeAheadLog_) {
+            writeAheadLog_->replay([this](KeyVal &&kv) { addToStorage(kv.key, std::move(kv.value)); });
+        }
+    }
 
     /**
      * @brief Adds new key-value pair to the storage.
@@ -66,53 +171,171 @@ class Supermap : public KeyValueStorage<Key, Value, IndexT> {
      * @param value Associated value.
      */
     void add(const Key &key, Value &&value) override {
-        diskDataStorage_->append(std::make_unique<KeyVal>(key, value));
-        innerStorage_->add(key, diskDataStorage_->getLastElementIndex());
-        if (innerStorage_->getUpperSizeBound() >= keyIndexBatchSize_) {
-            dropRamIndexToDisk();
+        if (writeAheadLog_) {
+            writeAheadLog_->append(KeyVal(key, value));
         }
+        addToStorage(key, std::move(value));
+    }
 
-        IndexT notSortedStorageSize = diskDataStorage_->getNotSortedItemsCount();
-        IndexT totalStorageSize = diskDataStorage_->getItemsCount();
+    /**
+     * @return Object of type @p Value which corresponds to given key @p k.
+     * @throws KeyException If key is not in the storage.
+     */
+    std::optional<Value> getValue(const Key &k) override {
+        return findValue(k, nullptr);
+    }
 
-        double notSortedPart = static_cast<double>(notSortedStorageSize) / static_cast<double>(totalStorageSize);
+    /**
+     * @return Object of type @p Value which corresponds to given key @p k.
+     * Filters of disk index use the hash @p keyHash of @p k instead of hashing it again.
+     */
+    std::optional<Value> getValueHashed(const Key &k, const hashTools::KeyHash &keyHash) override {
+        return findValue(k, &keyHash);
+    }
 
-        if (notSortedPart >= maxNotSortedPart_) {
-            dropRamIndexToDisk();
-            shrinkDataStorage();
+    /**
+     * @return Objects of type @p Value which correspond to every key of @p keys, in the same order.
+     * Keys are sorted, so that every disk index storage is searched once for the whole batch,
+     * and values are read in the order of their indices in the data storage.
+     */
+    std::vector<std::optional<Value>> multiGet(const std::vector<Key> &keys) override {
+        return findValues(keys, nullptr);
+    }
+
+    /**
+     * @return Objects of type @p Value which correspond to every key of @p keys, in the same order.
+     * Filters of disk index use the hashes @p keyHashes of @p keys instead of hashing them again.
+     */
+    std::vector<std::optional<Value>> multiGetHashed(const std::vector<Key> &keys,
+                                                     const std::vector<hashTools::KeyHash> &keyHashes) override {
+        return findValues(keys, &keyHashes);
+    }
+
+    /**
+     * @return Upper bound of number of the unique keys in the storage.
+     */
+    IndexT getUpperSizeBound() const noexcept override {
+        IndexT bound = diskDataStorage_->getSortedItemsCount() + diskDataStorage_->getNotSortedItemsCount();
+        if (frozen_.has_value()) {
+            bound += frozen_->data->getSortedItemsCount() + frozen_->data->getNotSortedItemsCount();
         }
+        return bound;
     }
 
     /**
-     * @return Object of type @p Value which corresponds to given key @p k.
-     * @throws KeyException If key is not in the storage.
+     * @brief Writes all items to disk and saves the storage state to the manifest,
+     * so that storage can be reopened from it. Write-ahead log is cleared after that.
+     * @throws IllegalStateException if storage is not persistent.
      */
-    std::optional<Value> getValue(const Key &k) override {
-        IndexT index;
-        if (auto optIndex = innerStorage_->getValue(k); optIndex.has_value()) {
-            index = optIndex.value();
-        } else {
-            std::optional<KeyIndex> foundOnDisk = diskIndex_->find(
-                k,
-                [](const KeyIndex &ki, const Key &key) { return ki.key < key; },
-                [](const KeyIndex &ki, const Key &key) { return ki.key == key; }
-            );
-            if (!foundOnDisk.has_value()) {
-                return std::nullopt;
+    void checkpoint() {
+        if (!persistentFileManager_) {
+            throw IllegalStateException("Only persistent storage can be checkpointed");
+        }
+        if (shrinkResult_.valid()) {
+            completeShrink();
+        }
+        dropRamIndexToDisk();
+        installFlushedMemtables(0);
+        diskDataStorage_->flush();
+
+        ManifestType manifest;
+        manifest.notSortedPath = diskDataStorage_->getNotSortedStorageFilePath();
+        manifest.notSortedItemsCount = diskDataStorage_->getNotSortedItemsCount();
+        manifest.sortedPath = diskDataStorage_->getSortedStorageFilePath();
+        manifest.sortedItemsCount = diskDataStorage_->getSortedItemsCount();
+        manifest.notSortedBase = diskDataStorage_->getNotSortedBase();
+        if (baseIndex_) {
+            manifest.baseIndex = getIndexStorageState(*baseIndex_);
+        }
+        std::vector<std::shared_ptr<IndexStorageBase>> indexStorages = diskIndex_->getStorages();
+        for (const auto &storage : indexStorages) {
+            manifest.indexStorages.push_back(getIndexStorageState(*storage));
+        }
+
+        std::unordered_set<std::string> referencedFiles = manifest.getReferencedFiles();
+        for (const auto &file : referencedFiles) {
+            persistentFileManager_->sync(file);
+        }
+        manifest.write(*persistentFileManager_);
+        persistentFileManager_->pin(referencedFiles);
+
+        std::unordered_set<std::string> filterFiles;
+        for (const auto &file : filterFiles_) {
+            if (referencedFiles.count(file) == 0) {
+                persistentFileManager_->remove(file);
             }
-            index = foundOnDisk.value().value;
         }
-        return std::optional{diskDataStorage_->get(index).value};
+        if (manifest.baseIndex.has_value()) {
+            filterFiles.insert(manifest.baseIndex->filterPath);
+        }
+        for (const auto &storage : manifest.indexStorages) {
+            filterFiles.insert(storage.filterPath);
+        }
+        filterFiles_ = std::move(filterFiles);
+        if (writeAheadLog_) {
+            writeAheadLog_->clear();
+        }
     }
 
     /**
-     * @return Upper bound of number of the unique keys in the storage.
+     * @return Memory and false positive probabilities of all disk index filters.
      */
-    IndexT getUpperSizeBound() const noexcept override {
-        return diskDataStorage_->getSortedItemsCount() + diskDataStorage_->getNotSortedItemsCount();
+    FilterStats getFilterStats() {
+        installFlushedMemtables(0);
+        FilterStats stats;
+        collectFilterStats(stats, *diskIndex_, baseIndex_.get());
+        if (frozen_.has_value()) {
+            collectFilterStats(stats, *frozen_->index, frozen_->baseIndex.get());
+        }
+        return stats;
+    }
+
+    /**
+     * @brief Checkpoints persistent storage.
+     */
+    ~Supermap() override {
+        if (!persistentFileManager_) {
+            return;
+        }
+        try {
+            checkpoint();
+        } catch (...) {
+            // storage will be restored from the previous manifest and the write-ahead log
+        }
     }
 
   private:
+    /**
+     * @brief Adds new key-value pair to the storage without logging it.
+     * @param key Key to add.
+     * @param value Associated value.
+     */
+    void addToStorage(const Key &key, Value &&value) {
+        diskDataStorage_->append(std::make_unique<KeyVal>(key, value));
+        innerStorage_->add(key, diskDataStorage_->getLastElementIndex());
+        if (innerStorage_->getUpperSizeBound() >= keyIndexBatchSize_) {
+            dropRamIndexToDisk();
+        }
+        installFlushedMemtables(maxImmutableMemtables_);
+
+        if (shrinkResult_.valid()) {
+            if (shrinkResult_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                return;
+            }
+            completeShrink();
+        }
+
+        IndexT notSortedStorageSize = diskDataStorage_->getNotSortedItemsCount();
+        IndexT totalStorageSize = diskDataStorage_->getSortedItemsCount() + notSortedStorageSize;
+
+        double notSortedPart = static_cast<double>(notSortedStorageSize) / static_cast<double>(totalStorageSize);
+
+        if (notSortedPart >= maxNotSortedPart_) {
+            dropRamIndexToDisk();
+            shrinkDataStorage();
+        }
+    }
+
     /**
      * @param s Initial string.
      * @param len Number of random characters.
@@ -134,38 +357,350 @@ class Supermap : public KeyValueStorage<Key, Value, IndexT> {
         return addRandomString(indexFilesPrefix + "block-" + std::to_string(diskIndex_->getItemsCount()));
     }
 
+    /**
+     * @brief Writes index in RAM to the new disk index storage. If index is flushed in background,
+     * it is frozen and handed to the flush worker instead, and the new index in RAM is started.
+     */
     void dropRamIndexToDisk() {
         if (innerStorage_->getUpperSizeBound() == 0) {
             return;
         }
-        std::vector<KeyIndex> newBlockKeyIndex = std::move(*innerStorage_).extract();
-        auto newBlock = IndexStorageBase(
-            newBlockKeyIndex.begin(),
-            newBlockKeyIndex.end(),
-            true,
-            getNewBlockName(),
-            diskDataStorage_->getFileManager(),
-            [](const KeyIndex &a, const KeyIndex &b) { return a.key < b.key; },
-            [](const KeyIndex &a, const KeyIndex &b) { return a.key == b.key; },
-            registerSupplier_
+        updateFilterPolicy();
+        if (maxImmutableMemtables_ == 0) {
+            auto newBlock = IndexStorageBase(
+                innerStorage_->getUpperSizeBound(),
+                [this](const std::function<void(const KeyIndex &)> &consumer) {
+                    std::move(*innerStorage_).extractSorted(consumer);
+                },
+                getNewBlockName(),
+                diskDataStorage_->getFileManager(),
+                registerSupplier_
+            );
+            diskIndex_->append(keyIndexStorageSupplier_(std::move(newBlock)));
+            return;
+        }
+        std::shared_ptr<RamStorageBase> memtable = std::move(innerStorage_);
+        innerStorage_ = memtable->createLikeThis();
+        auto flush = [memtable,
+                      blockName = getNewBlockName(),
+                      fileManager = diskDataStorage_->getFileManager(),
+                      registerSupplier = registerSupplier_,
+                      keyIndexStorageSupplier = keyIndexStorageSupplier_]() {
+            return keyIndexStorageSupplier(IndexStorageBase(
+                memtable->getUpperSizeBound(),
+                [&memtable](const std::function<void(const KeyIndex &)> &consumer) {
+                    memtable->forEachSorted(consumer);
+                },
+                blockName,
+                fileManager,
+                registerSupplier
+            ));
+        };
+        immutableMemtables_.push_back({memtable, std::async(std::launch::async, flush)});
+    }
+
+    /**
+     * @brief Appends disk index storages of flushed immutable indices to the disk index, from the oldest one,
+     * and forgets these indices. Stops at the first index, which is not flushed yet,
+     * unless there are more than @p maxWaiting indices left: then waits for its flush.
+     * @param maxWaiting Number of immutable indices, which may be left waiting for the flush.
+     */
+    void installFlushedMemtables(std::size_t maxWaiting) {
+        while (!immutableMemtables_.empty()
+            && (immutableMemtables_.size() > maxWaiting
+                || immutableMemtables_.front().indexStorage.wait_for(std::chrono::seconds(0))
+                    == std::future_status::ready)) {
+            diskIndex_->append(immutableMemtables_.front().indexStorage.get());
+            immutableMemtables_.pop_front();
+        }
+    }
+
+    /**
+     * @brief Saves filter of the disk index storage next to the storage file, unless it is already saved.
+     * @return Manifest entry of the disk index storage.
+     */
+    typename ManifestType::IndexStorageState getIndexStorageState(IndexStorageBase &storage) {
+        std::string filterPath = storage.getStorageFilePath() + FILTER_FILE_SUFFIX;
+        if (filterFiles_.count(filterPath) == 0 && !persistentFileManager_->exists(filterPath)) {
+            auto output = persistentFileManager_->getOutputStream(filterPath, false);
+            storage.getRegisterInfo().additional->save(output->get());
+            output->flush();
+        }
+        return {storage.getStorageFilePath(), storage.getItemsCount(), storage.getFences(), filterPath};
+    }
+
+    /**
+     * @brief Opens disk index storage, saved in the manifest. Its filter is read on the first lookup.
+     * @param state Manifest entry of the storage.
+     * @return Opened storage.
+     */
+    std::unique_ptr<IndexStorageBase> openIndexStorage(const typename ManifestType::IndexStorageState &state) {
+        filterFiles_.insert(state.filterPath);
+        std::shared_ptr<FilterType> filter = std::make_shared<LazyFilter<Key>>(
+            persistentFileManager_,
+            state.filterPath,
+            registerSupplier_()->getRegisteredItemsInfo()->clone()
+        );
+        auto storageRegister = std::make_unique<RegisterBase>(
+            [filter]() { return filter; },
+            [](const KeyIndex &ki) { return ki.key; }
         );
-        diskIndex_->append(keyIndexStorageSupplier_(std::move(newBlock)));
+        storageRegister->seal();
+        return keyIndexStorageSupplier_(IndexStorageBase(
+            state.path,
+            diskDataStorage_->getFileManager(),
+            state.itemsCount,
+            std::move(storageRegister),
+            state.fences
+        ));
     }
 
+    /**
+     * @brief Adds stats of filters of disk index of one generation to @p stats.
+     */
+    static void collectFilterStats(FilterStats &stats, IndexStorageListBase &index, IndexStorageBase *baseIndex) {
+        std::vector<std::shared_ptr<IndexStorageBase>> storages = index.getStorages();
+        auto collect = [&stats](IndexStorageBase &storage) {
+            std::shared_ptr<FilterType> filter = storage.getRegisterInfo().additional;
+            typename FilterStats::StorageFilter storageFilter{
+                storage.getItemsCount(),
+                filter->getMemoryBits(),
+                filter->getFalsePositiveProbability()
+            };
+            stats.memoryBits += storageFilter.memoryBits;
+            stats.expectedFalsePositives += storageFilter.falsePositiveProbability;
+            stats.storages.push_back(storageFilter);
+        };
+        for (const auto &storage : storages) {
+            collect(*storage);
+        }
+        if (baseIndex != nullptr) {
+            collect(*baseIndex);
+        }
+    }
+
+    /**
+     * @brief Tells filter policy the current number of keys.
+     */
+    void updateFilterPolicy() {
+        if (filterPolicy_) {
+            filterPolicy_->setTotalItems(getUpperSizeBound());
+        }
+    }
+
+    /**
+     * @param k Key to find.
+     * @param keyHash Hash of @p k, may be @p nullptr.
+     * @return Object of type @p Value which corresponds to given key @p k.
+     */
+    std::optional<Value> findValue(const Key &k, const hashTools::KeyHash *keyHash) {
+        std::optional<IndexT> index = innerStorage_->getValue(k);
+        for (auto it = immutableMemtables_.rbegin(); !index.has_value() && it != immutableMemtables_.rend(); ++it) {
+            index = it->memtable->getValue(k);
+        }
+        if (!index.has_value()) {
+            index = findIndexOnDisk(k, keyHash, *diskIndex_, baseIndex_.get());
+        }
+        if (!index.has_value() && frozen_.has_value()) {
+            index = findIndexOnDisk(k, keyHash, *frozen_->index, frozen_->baseIndex.get());
+        }
+        if (!index.has_value()) {
+            return std::nullopt;
+        }
+        return std::optional{readValue(index.value())};
+    }
+
+    /**
+     * @brief Searches for the values of all @p keys, using one batched search per disk index storage.
+     * @param keys Keys to find.
+     * @param keyHashes Hashes of @p keys, may be @p nullptr.
+     * @return Objects of type @p Value which correspond to every key of @p keys, in the same order.
+     */
+    std::vector<std::optional<Value>> findValues(const std::vector<Key> &keys,
+                                                 const std::vector<hashTools::KeyHash> *keyHashes) {
+        std::vector<std::size_t> order(keys.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&keys](std::size_t a, std::size_t b) { return keys[a] < keys[b]; });
+        std::vector<std::optional<IndexT>> indices(keys.size());
+        std::vector<std::size_t> missing;
+        for (std::size_t i : order) {
+            indices[i] = innerStorage_->getValue(keys[i]);
+            for (auto it = immutableMemtables_.rbegin();
+                 !indices[i].has_value() && it != immutableMemtables_.rend();
+                 ++it) {
+                indices[i] = it->memtable->getValue(keys[i]);
+            }
+            if (!indices[i].has_value()) {
+                missing.push_back(i);
+            }
+        }
+        missing = findIndicesOnDisk(keys, keyHashes, missing, *diskIndex_, baseIndex_.get(), indices);
+        if (frozen_.has_value()) {
+            findIndicesOnDisk(keys, keyHashes, missing, *frozen_->index, frozen_->baseIndex.get(), indices);
+        }
+        std::vector<std::size_t> found;
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            if (indices[i].has_value()) {
+                found.push_back(i);
+            }
+        }
+        std::sort(found.begin(), found.end(), [&indices](std::size_t a, std::size_t b) {
+            return indices[a].value() < indices[b].value();
+        });
+        std::vector<std::optional<Value>> values(keys.size());
+        for (std::size_t i : found) {
+            values[i] = readValue(indices[i].value());
+        }
+        return values;
+    }
+
+    /**
+     * @return Value of the item with index @p index in the data storage of the current or of the frozen generation.
+     */
+    Value readValue(IndexT index) const {
+        if (frozen_.has_value() && index < diskDataStorage_->getNotSortedBase()) {
+            return frozen_->data->get(index).value;
+        }
+        return diskDataStorage_->get(index).value;
+    }
+
+    /**
+     * @brief Searches for the index of key @p k in disk index of one generation.
+     * @param k Key to find.
+     * @param keyHash Hash of @p k, may be @p nullptr.
+     * @param index Index storages list of not sorted part of generation data storage.
+     * @param baseIndex Index of sorted part of generation data storage, may be @p nullptr.
+     * @return Data storage index of @p k, if any.
+     */
+    static std::optional<IndexT> findIndexOnDisk(const Key &k,
+                                                 const hashTools::KeyHash *keyHash,
+                                                 IndexStorageListBase &index,
+                                                 IndexStorageBase *baseIndex) {
+        auto less = [](const KeyIndex &ki, const Key &key) { return ki.key < key; };
+        auto equal = [](const KeyIndex &ki, const Key &key) { return ki.key == key; };
+        std::optional<KeyIndex> foundOnDisk = keyHash
+                                              ? index.findHashed(k, *keyHash, less, equal)
+                                              : index.find(k, less, equal);
+        if (!foundOnDisk.has_value() && baseIndex != nullptr) {
+            foundOnDisk = keyHash
+                          ? baseIndex->findHashed(k, *keyHash, less, equal)
+                          : baseIndex->find(k, less, equal);
+        }
+        if (!foundOnDisk.has_value()) {
+            return std::nullopt;
+        }
+        return foundOnDisk.value().value;
+    }
+
+    /**
+     * @brief Searches for the indices of several keys in disk index of one generation.
+     * @param keys Keys to find.
+     * @param keyHashes Hashes of @p keys, may be @p nullptr.
+     * @param missing Positions in @p keys of keys to find, ordered by keys.
+     * @param index Index storages list of not sorted part of generation data storage.
+     * @param baseIndex Index of sorted part of generation data storage, may be @p nullptr.
+     * @param indices Data storage indices of found keys are written there by their positions.
+     * @return Positions of keys, which were not found, in the same order.
+     */
+    static std::vector<std::size_t> findIndicesOnDisk(const std::vector<Key> &keys,
+                                                      const std::vector<hashTools::KeyHash> *keyHashes,
+                                                      std::vector<std::size_t> missing,
+                                                      IndexStorageListBase &index,
+                                                      IndexStorageBase *baseIndex,
+                                                      std::vector<std::optional<IndexT>> &indices) {
+        auto less = [](const KeyIndex &ki, const Key &key) { return ki.key < key; };
+        auto equal = [](const KeyIndex &ki, const Key &key) { return ki.key == key; };
+        std::array<Findable<KeyIndex, Key> *, 2> storages{&index, baseIndex};
+        for (Findable<KeyIndex, Key> *storage : storages) {
+            if (storage == nullptr || missing.empty()) {
+                continue;
+            }
+            std::vector<Key> batch;
+            std::vector<hashTools::KeyHash> batchHashes;
+            for (std::size_t i : missing) {
+                batch.push_back(keys[i]);
+                if (keyHashes) {
+                    batchHashes.push_back((*keyHashes)[i]);
+                }
+            }
+            std::vector<std::optional<KeyIndex>> found
+                = storage->findAll(batch, keyHashes ? &batchHashes : nullptr, less, equal);
+            std::vector<std::size_t> stillMissing;
+            for (std::size_t j = 0; j < missing.size(); ++j) {
+                if (found[j].has_value()) {
+                    indices[missing[j]] = found[j].value().value;
+                } else {
+                    stillMissing.push_back(missing[j]);
+                }
+            }
+            missing = std::move(stillMissing);
+        }
+        return missing;
+    }
+
+    /**
+     * @brief Freezes current generation and starts its shrink. New items will be appended
+     * to the next generation storage. If shrink is not done in background, waits for its completion.
+     */
     void shrinkDataStorage() {
-        auto actualIndex = keyIndexStorageSupplier_(
-            diskDataStorage_->shrink(
-                keyIndexBatchSize_,
-                addRandomString(indexFilesPrefix + "new-keys=" + std::to_string(getUpperSizeBound()))
-            ));
-        std::unique_ptr<IndexStorageListBase> newIndexList = indexListSupplier_();
-        newIndexList->append(std::move(actualIndex));
-        diskIndex_ = std::move(newIndexList);
+        assert(!frozen_.has_value());
+        installFlushedMemtables(0);
+        updateFilterPolicy();
+        diskDataStorage_->flush();
+        std::shared_ptr<const DiskStorage> frozenData = std::move(diskDataStorage_);
+        frozen_ = Generation{frozenData, std::move(diskIndex_), std::move(baseIndex_)};
+        diskDataStorage_ = std::make_unique<DiskStorage>(frozenData->createNextGeneration(
+            addRandomString("storage-not-sorted"),
+            addRandomString("storage-sorted")
+        ));
+        diskIndex_ = indexListSupplier_();
+
+        auto shrink = [frozenData,
+                       batchSize = keyIndexBatchSize_,
+                       prefix = addRandomString("shrink"),
+                       newIndexFileName = addRandomString(
+                           indexFilesPrefix + "new-keys=" + std::to_string(getUpperSizeBound()))]() {
+            return frozenData->shrinkToNew(batchSize, prefix, newIndexFileName);
+        };
+        shrinkResult_ = std::async(backgroundShrink_ ? std::launch::async : std::launch::deferred, shrink);
+        if (!backgroundShrink_) {
+            completeShrink();
+        }
+    }
+
+    /**
+     * @brief Waits for the shrink of the frozen generation and replaces it
+     * with the shrunk storage and its index.
+     */
+    void completeShrink() {
+        auto [shrunk, actualIndex] = shrinkResult_.get();
+        diskDataStorage_->resetSortedWith(std::move(shrunk));
+        baseIndex_ = keyIndexStorageSupplier_(std::move(actualIndex));
+        frozen_.reset();
     }
 
+    /**
+     * @brief Frozen index in RAM, which is being flushed to disk.
+     */
+    struct ImmutableMemtable {
+        std::shared_ptr<RamStorageBase> memtable;
+        std::future<std::unique_ptr<IndexStorageBase>> indexStorage;
+    };
+
+    /**
+     * @brief Data storage generation, which is being shrunk, with its index.
+     */
+    struct Generation {
+        std::shared_ptr<const DiskStorage> data;
+        std::shared_ptr<IndexStorageListBase> index;
+        std::shared_ptr<IndexStorageBase> baseIndex;
+    };
+
     std::unique_ptr<RamStorageBase> innerStorage_;
     std::unique_ptr<DiskStorage> diskDataStorage_;
     std::unique_ptr<IndexStorageListBase> diskIndex_;
+    std::unique_ptr<IndexStorageBase> baseIndex_;
+    std::optional<Generation> frozen_;
     std::function<std::unique_ptr<IndexStorageBase>(IndexStorageBase &&)> keyIndexStorageSupplier_;
     std::function<std::unique_ptr<IndexStorageListBase>()> indexListSupplier_;
     std::function<std::unique_ptr<RegisterBase>()> registerSupplier_;
@@ -173,6 +708,22 @@ class Supermap : public KeyValueStorage<Key, Value, IndexT> {
     const std::string indexFilesPrefix = "index-";
     mutable std::mt19937 random;
     const double maxNotSortedPart_;
+    const bool backgroundShrink_;
+    std::unique_ptr<io::WriteAheadLog<KeyVal>> writeAheadLog_;
+    std::shared_ptr<io::PinningFileManager> persistentFileManager_;
+    std::shared_ptr<FilterPolicy> filterPolicy_;
+
+    /**
+     * @brief Saved filters of index storages, which are referenced by the last manifest.
+     */
+    std::unordered_set<std::string> filterFiles_;
+    std::future<std::pair<DiskStorage, IndexStorageBase>> shrinkResult_;
+    const std::size_t maxImmutableMemtables_;
+
+    /**
+     * @brief Immutable indices in RAM, from the oldest to the newest.
+     */
+    std::deque<ImmutableMemtable> immutableMemtables_;
 };
 
 } // supermap
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "Filter.hpp"
+#include "io/SerializeHelper.hpp"
+#include "io/ShallowSerializer.hpp"
+#include "exception/IllegalStateException.hpp"
+#include "hasher/XXHasher.hpp"
+#include "hasher/HashTools.hpp"
+
+namespace supermap {
+
+/**
+ * @brief Static xor filter with 8-bit fingerprints.
+ * Hashes of added elements are collected until the filter is sealed, then the filter is built at once.
+ * It takes about 9.84 bits per element, has false positive probability 1/256,
+ * and each check reads exactly three fingerprints.
+ * Before the filter is sealed, it can not filter anything.
+ * @tparam T Type of elements.
+ */
+template <typename T>
+class XorFilter : public Filter<T> {
+  private:
+    using BaseFilter = Filter<T>;
+
+  public:
+    /**
+     * @brief Number of attempts to build the filter with different seeds, after which sealing fails.
+     */
+    static constexpr std::size_t MAX_BUILD_ATTEMPTS = 100;
+
+    /**
+     * @param hasher Hasher of serialized elements.
+     * @param seed Seed of the generator of seeds, which are tried during the build.
+     */
+    explicit XorFilter(std::unique_ptr<Hasher> &&hasher, std::uint64_t seed = std::random_device{}())
+        : hasher_(std::move(hasher)), buildSeed_(seed) {}
+
+    XorFilter(const XorFilter &other)
+        : hasher_(other.hasher_->clone()),
+          buildSeed_(other.buildSeed_),
+          hashes_(other.hashes_),
+          seed_(other.seed_),
+          blockLength_(other.blockLength_),
+          fingerprints_(other.fingerprints_),
+          sealed_(other.sealed_) {}
+
+    /**
+     * @brief Add an element to filter.
+     * @param value Element to add.
+     * @throws IllegalStateException if filter is already sealed.
+     */
+    void add(const T &value) override {
+        if (sealed_) {
+            throw supermap::IllegalStateException("Elements can not be added to sealed xor filter");
+        }
+        hashes_.push_back(getHash(value));
+    }
+
+    /**
+     * @return @p false if @p value was never added to sealed filter, anything otherwise.
+     */
+    bool mightContain(const T &value) const override {
+        return mightContainHashed(value, hashTools::hashKey(*hasher_, value));
+    }
+
+    /**
+     * @return @p false if @p value was never added to sealed filter, anything otherwise.
+     * @p valueHash is used, if it was computed by the hasher of this filter.
+     */
+    bool mightContainHashed(const T &value, const hashTools::KeyHash &valueHash) const override {
+        if (!sealed_) {
+            return true;
+        }
+        std::uint64_t hash = mix(valueHash.isComputedBy(*hasher_) ? valueHash.value : getHash(value), seed_);
+        return getFingerprint(hash) == (fingerprints_[getPosition(hash, 0)]
+            ^ fingerprints_[getPosition(hash, 1)]
+            ^ fingerprints_[getPosition(hash, 2)]);
+    }
+
+    std::unique_ptr<BaseFilter> clone() const override {
+        return std::make_unique<XorFilter<T>>(*this);
+    }
+
+    /**
+     * @brief Reserves memory for hashes of @p numberOfElements elements.
+     */
+    void reserve(std::uint64_t numberOfElements) override {
+        hashes_.reserve(numberOfElements);
+    }
+
+    /**
+     * @brief Builds the filter from all added elements.
+     * @throws IllegalStateException if filter could not be built.
+     */
+    void seal() override {
+        if (sealed_) {
+            return;
+        }
+        std::sort(hashes_.begin(), hashes_.end());
+        hashes_.erase(std::unique(hashes_.begin(), hashes_.end()), hashes_.end());
+        build();
+        hashes_.clear();
+        hashes_.shrink_to_fit();
+        sealed_ = true;
+    }
+
+    [[nodiscard]] std::uint64_t getMemoryBits() const override {
+        return fingerprints_.size() * 8;
+    }
+
+    [[nodiscard]] double getFalsePositiveProbability() const override {
+        return sealed_ ? 1.0 / 256 : 1;
+    }
+
+    /**
+     * @brief Writes sealed filter to @p os.
+     * @param os Output stream.
+     * @throws IllegalStateException if filter is not sealed.
+     */
+    void save(std::ostream &os) const override {
+        if (!sealed_) {
+            throw supermap::IllegalStateException("Only sealed xor filter can be saved");
+        }
+        io::serialize<std::uint64_t>(seed_, os);
+        io::serialize<std::uint64_t>(blockLength_, os);
+        os.write(reinterpret_cast<const char *>(fingerprints_.data()),
+                 static_cast<std::streamsize>(fingerprints_.size()));
+    }
+
+    /**
+     * @brief Reads sealed filter, written by @p save, from @p is.
+     * @param is Input stream.
+     */
+    void restore(std::istream &is) override {
+        seed_ = io::deserialize<std::uint64_t>(is);
+        blockLength_ = io::deserialize<std::uint64_t>(is);
+        fingerprints_.assign(3 * blockLength_, 0);
+        is.read(reinterpret_cast<char *>(fingerprints_.data()), static_cast<std::streamsize>(fingerprints_.size()));
+        if (!is.good() || blockLength_ == 0) {
+            throw IOException("Unable to restore xor filter");
+        }
+        hashes_.clear();
+        sealed_ = true;
+    }
+
+  private:
+    /**
+     * @brief Finds fingerprints, such that xor of three fingerprints of every element
+     * is equal to its own fingerprint. Every element is assigned to the position,
+     * which is not used by any other unassigned element, until all elements are assigned.
+     */
+    void build() {
+        blockLength_ = (32 + static_cast<std::uint64_t>(1.23 * static_cast<double>(hashes_.size()))) / 3 + 1;
+        const std::size_t capacity = 3 * blockLength_;
+        std::vector<std::uint64_t> xorMasks(capacity);
+        std::vector<std::uint32_t> counts(capacity);
+        std::vector<std::size_t> queue;
+        std::vector<std::pair<std::uint64_t, std::size_t>> assigned;
+        queue.reserve(capacity);
+        assigned.reserve(hashes_.size());
+        std::mt19937_64 rnd(buildSeed_);
+        for (std::size_t attempt = 0; attempt < MAX_BUILD_ATTEMPTS; ++attempt) {
+            seed_ = rnd();
+            std::fill(xorMasks.begin(), xorMasks.end(), 0);
+            std::fill(counts.begin(), counts.end(), 0);
+            for (std::uint64_t keyHash : hashes_) {
+                std::uint64_t hash = mix(keyHash, seed_);
+                for (std::size_t i = 0; i < 3; ++i) {
+                    std::size_t position = getPosition(hash, i);
+                    xorMasks[position] ^= hash;
+                    ++counts[position];
+                }
+            }
+            queue.clear();
+            assigned.clear();
+            for (std::size_t position = 0; position < capacity; ++position) {
+                if (counts[position] == 1) {
+                    queue.push_back(position);
+                }
+            }
+            while (!queue.empty()) {
+                std::size_t position = queue.back();
+                queue.pop_back();
+                if (counts[position] != 1) {
+                    continue;
+                }
+                std::uint64_t hash = xorMasks[position];
+                assigned.emplace_back(hash, position);
+                for (std::size_t i = 0; i < 3; ++i) {
+                    std::size_t other = getPosition(hash, i);
+                    xorMasks[other] ^= hash;
+                    if (--counts[other] == 1) {
+                        queue.push_back(other);
+                    }
+                }
+            }
+            if (assigned.size() == hashes_.size()) {
+                fingerprints_.assign(capacity, 0);
+                for (auto it = assigned.rbegin(); it != assigned.rend(); ++it) {
+                    auto [hash, position] = *it;
+                    fingerprints_[position] = getFingerprint(hash)
+                        ^ fingerprints_[getPosition(hash, 0)]
+                        ^ fingerprints_[getPosition(hash, 1)]
+                        ^ fingerprints_[getPosition(hash, 2)];
+                }
+                return;
+            }
+        }
+        throw supermap::IllegalStateException("Unable to build xor filter");
+    }
+
+    std::uint64_t getHash(const T &value) const {
+        return hashTools::hashKey(*hasher_, value).value;
+    }
+
+    static std::uint64_t mix(std::uint64_t hash, std::uint64_t seed) {
+        return hashTools::mix(hash, seed);
+    }
+
+    static std::uint8_t getFingerprint(std::uint64_t hash) {
+        return static_cast<std::uint8_t>(hash ^ (hash >> 32));
+    }
+
+    /**
+     * @return Position of the element with hash @p hash in the @p block -th third of fingerprints.
+     */
+    std::size_t getPosition(std::uint64_t hash, std::size_t block) const {
+        auto rotated = static_cast<std::uint32_t>(block == 0 ? hash : (hash << (21 * block)) | (hash >> (64 - 21 * block)));
+        return block * blockLength_ + static_cast<std::size_t>((static_cast<std::uint64_t>(rotated) * blockLength_) >> 32);
+    }
+
+    std::unique_ptr<Hasher> hasher_;
+    std::uint64_t buildSeed_;
+    std::vector<std::uint64_t> hashes_;
+    std::uint64_t seed_ = 0;
+    std::uint64_t blockLength_ = 0;
+    std::vector<std::uint8_t> fingerprints_;
+    bool sealed_ = false;
+};
+
+} // supermap
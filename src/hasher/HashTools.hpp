@@ -1,15 +1,79 @@
 #pragma once
 
+#include <array>
+#include <sstream>
+#include <typeinfo>
+
 #include "io/SerializeHelper.hpp"
 #include "Hasher.hpp"
 
 namespace supermap::hashTools {
 
+/**
+ * @brief Seed of key hashes, computed by @p hashKey.
+ */
+constexpr std::uint64_t KEY_HASH_SEED = 239;
+
+/**
+ * @brief Hashes serialized @p key. Keys of fixed serialized size are serialized
+ * to the stack buffer of this size, other keys are serialized to the string.
+ * @param hasher Hasher of serialized keys.
+ * @param key Key to hash.
+ * @param seed Hash seed.
+ * @return Hash of @p key.
+ */
 template <typename T>
-std::uint64_t hashWith(const Hasher &hasher, const T key, std::uint64_t seed) {
-    std::stringstream keyStream;
-    io::serialize(key, keyStream);
-    return hasher.hash(keyStream.str(), seed);
+std::uint64_t hashWith(const Hasher &hasher, const T &key, std::uint64_t seed) {
+    if constexpr (io::HasFixedDeserializedSize<T>::value) {
+        std::array<char, io::FixedDeserializedSizeRegister<T>::exactDeserializedSize> data;
+        io::serializeTo(key, data.data());
+        return hasher.hash(data.data(), data.size(), seed);
+    } else {
+        std::stringstream keyStream;
+        io::serialize(key, keyStream);
+        return hasher.hash(keyStream.str(), seed);
+    }
+}
+
+/**
+ * @brief Hash of a key, which is computed once per request and then reused
+ * by the shard routing and by every filter on the request path.
+ */
+struct KeyHash {
+    std::uint64_t value;
+    const Hasher *hasher;
+
+    /**
+     * @return If this hash was computed by the hasher of the same type as @p other,
+     * so that @p other would compute exactly the same hash.
+     */
+    [[nodiscard]] bool isComputedBy(const Hasher &other) const {
+        return typeid(*hasher) == typeid(other);
+    }
+};
+
+/**
+ * @brief Computes hash of @p key, which can be shared by all its users.
+ * @param hasher Hasher of serialized keys.
+ * @param key Key to hash.
+ * @return Hash of @p key, computed with seed @p KEY_HASH_SEED.
+ */
+template <typename T>
+KeyHash hashKey(const Hasher &hasher, const T &key) {
+    return {hashWith(hasher, key, KEY_HASH_SEED), &hasher};
+}
+
+/**
+ * @brief Derives independent well mixed hash from @p hash and @p seed.
+ */
+inline std::uint64_t mix(std::uint64_t hash, std::uint64_t seed) {
+    hash += seed;
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ull;
+    hash ^= hash >> 33;
+    return hash;
 }
 
 } // namespace supermap
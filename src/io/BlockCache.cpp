@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+#include "BlockCache.hpp"
+
+namespace supermap::io {
+
+std::size_t BlockCache::BlockKeyHash::operator()(const BlockKey &key) const noexcept {
+    std::size_t hash = FileIdHash{}(key.file);
+    hash ^= std::hash<std::uint64_t>{}(key.blockIndex) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+std::size_t BlockCache::FileIdHash::operator()(const FileId &file) const noexcept {
+    std::size_t hash = std::hash<std::uint64_t>{}(file.inode);
+    hash ^= std::hash<std::uint64_t>{}(file.device) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+BlockCache::BlockCache(std::size_t capacityBytes)
+    : shardCapacity_(std::max<std::size_t>(1, capacityBytes / BLOCK_SIZE / SHARDS_NUMBER)),
+      shards_(SHARDS_NUMBER) {}
+
+bool BlockCache::read(FileId file, std::uint64_t blockIndex, std::size_t blockOffset, std::size_t length, char *dst) {
+    BlockKey key{file, blockIndex};
+    Shard &shard = getShard(key);
+    std::lock_guard lock(shard.mutex);
+    auto it = shard.entries.find(key);
+    if (it == shard.entries.end()) {
+        ++misses_;
+        return false;
+    }
+    ++hits_;
+    shard.recentlyUsed.splice(shard.recentlyUsed.begin(), shard.recentlyUsed, it->second);
+    std::memcpy(dst, it->second->second.data() + blockOffset, length);
+    return true;
+}
+
+std::uint64_t BlockCache::getEpoch(FileId file) const noexcept {
+    return epochs_[getEpochIndex(file)].load();
+}
+
+void BlockCache::insert(FileId file, std::uint64_t blockIndex, const Block &block, std::uint64_t epoch) {
+    BlockKey key{file, blockIndex};
+    Shard &shard = getShard(key);
+    std::lock_guard lock(shard.mutex);
+    if (epochs_[getEpochIndex(file)].load() != epoch) {
+        return;
+    }
+    if (auto it = shard.entries.find(key); it != shard.entries.end()) {
+        it->second->second = block;
+        shard.recentlyUsed.splice(shard.recentlyUsed.begin(), shard.recentlyUsed, it->second);
+        return;
+    }
+    shard.recentlyUsed.emplace_front(key, block);
+    shard.entries[key] = shard.recentlyUsed.begin();
+    shard.fileBlocks[file].insert(blockIndex);
+    if (shard.recentlyUsed.size() > shardCapacity_) {
+        evictLeastRecentlyUsed(shard);
+    }
+}
+
+void BlockCache::invalidate(FileId file) {
+    ++epochs_[getEpochIndex(file)];
+    for (Shard &shard : shards_) {
+        std::lock_guard lock(shard.mutex);
+        auto fileBlocksIt = shard.fileBlocks.find(file);
+        if (fileBlocksIt == shard.fileBlocks.end()) {
+            continue;
+        }
+        for (std::uint64_t blockIndex : fileBlocksIt->second) {
+            auto it = shard.entries.find(BlockKey{file, blockIndex});
+            shard.recentlyUsed.erase(it->second);
+            shard.entries.erase(it);
+        }
+        shard.fileBlocks.erase(fileBlocksIt);
+    }
+}
+
+std::size_t BlockCache::getHits() const noexcept {
+    return hits_;
+}
+
+std::size_t BlockCache::getMisses() const noexcept {
+    return misses_;
+}
+
+BlockCache::Shard &BlockCache::getShard(const BlockKey &key) {
+    return shards_[BlockKeyHash{}(key) % SHARDS_NUMBER];
+}
+
+void BlockCache::evictLeastRecentlyUsed(Shard &shard) {
+    const BlockKey &key = shard.recentlyUsed.back().first;
+    auto fileBlocksIt = shard.fileBlocks.find(key.file);
+    fileBlocksIt->second.erase(key.blockIndex);
+    if (fileBlocksIt->second.empty()) {
+        shard.fileBlocks.erase(fileBlocksIt);
+    }
+    shard.entries.erase(key);
+    shard.recentlyUsed.pop_back();
+}
+
+std::size_t BlockCache::getEpochIndex(FileId file) noexcept {
+    return FileIdHash{}(file) % EPOCHS_NUMBER;
+}
+
+} // supermap::io
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "FileDescriptorCache.hpp"
+
+namespace supermap::io {
+
+/**
+ * @brief Bounded cache of fixed-size file blocks, shared between all readers.
+ * Blocks are identified by the file identity and block number, so renaming
+ * a file keeps its blocks valid, and only changing file contents requires invalidation.
+ * Cache is split into independent shards with their own LRU lists and locks.
+ * Every shard also indexes its blocks by file, so that invalidation touches only the blocks of one file.
+ * Every file also has an epoch, which invalidation increments: a block, which was read before
+ * the invalidation, is not inserted after it. Files may share epochs, which only causes extra misses.
+ * All methods are thread-safe.
+ */
+class BlockCache {
+  public:
+    static constexpr std::size_t BLOCK_SIZE = 4096;
+    static constexpr std::size_t SHARDS_NUMBER = 16;
+    static constexpr std::size_t EPOCHS_NUMBER = 256;
+
+    using Block = std::array<char, BLOCK_SIZE>;
+
+    /**
+     * @param capacityBytes Memory budget of cached blocks.
+     * At least one block per shard is cached.
+     */
+    explicit BlockCache(std::size_t capacityBytes);
+
+    /**
+     * @brief Copies @p length bytes starting from @p blockOffset of the cached block to the @p dst.
+     * @param file Identity of the file.
+     * @param blockIndex Index of the block in the file.
+     * @param blockOffset Offset inside the block.
+     * @param length Number of bytes to copy. @p blockOffset + @p length must not exceed @p BLOCK_SIZE.
+     * @param dst Destination buffer.
+     * @return If block was found in cache.
+     */
+    bool read(FileId file, std::uint64_t blockIndex, std::size_t blockOffset, std::size_t length, char *dst);
+
+    /**
+     * @param file Identity of the file.
+     * @return Current epoch of the @p file, which must be taken before its block is read from the file.
+     */
+    [[nodiscard]] std::uint64_t getEpoch(FileId file) const noexcept;
+
+    /**
+     * @brief Puts block to the cache, evicting the least recently used block of the shard if needed.
+     * Block is dropped, if the file was invalidated since @p epoch was taken.
+     * @param file Identity of the file.
+     * @param blockIndex Index of the block in the file.
+     * @param block Complete block contents.
+     * @param epoch Epoch of the file, which was taken before the block was read.
+     */
+    void insert(FileId file, std::uint64_t blockIndex, const Block &block, std::uint64_t epoch);
+
+    /**
+     * @brief Drops all cached blocks of the @p file. Must be called
+     * every time after the contents of the file are changed not only by appending.
+     * @param file Identity of the file.
+     */
+    void invalidate(FileId file);
+
+    /**
+     * @return Number of successful reads.
+     */
+    [[nodiscard]] std::size_t getHits() const noexcept;
+
+    /**
+     * @return Number of reads of absent blocks.
+     */
+    [[nodiscard]] std::size_t getMisses() const noexcept;
+
+  private:
+    struct BlockKey {
+        FileId file;
+        std::uint64_t blockIndex;
+
+        bool operator==(const BlockKey &other) const noexcept {
+            return file == other.file && blockIndex == other.blockIndex;
+        }
+    };
+
+    struct BlockKeyHash {
+        std::size_t operator()(const BlockKey &key) const noexcept;
+    };
+
+    struct FileIdHash {
+        std::size_t operator()(const FileId &file) const noexcept;
+    };
+
+    using Entry = std::pair<BlockKey, Block>;
+
+    struct Shard {
+        std::list<Entry> recentlyUsed;
+        std::unordered_map<BlockKey, std::list<Entry>::iterator, BlockKeyHash> entries;
+        std::unordered_map<FileId, std::unordered_set<std::uint64_t>, FileIdHash> fileBlocks;
+        std::mutex mutex;
+    };
+
+    Shard &getShard(const BlockKey &key);
+
+    static void evictLeastRecentlyUsed(Shard &shard);
+
+    static std::size_t getEpochIndex(FileId file) noexcept;
+
+    const std::size_t shardCapacity_;
+    std::vector<Shard> shards_;
+    std::array<std::atomic<std::uint64_t>, EPOCHS_NUMBER> epochs_{};
+    std::atomic<std::size_t> hits_ = 0;
+    std::atomic<std::size_t> misses_ = 0;
+};
+
+} // supermap::io
@@ -1,30 +1,96 @@
+#include <algorithm>
 #include <cstring>
+#include <sys/stat.h>
 
 #include "DiskFileManager.hpp"
 
 namespace supermap::io {
 
+DiskFileManager::DiskFileManager(std::size_t maxOpenFiles, std::shared_ptr<BlockCache> blockCache)
+    : descriptors_(maxOpenFiles), blockCache_(std::move(blockCache)) {}
+
 std::unique_ptr<InputStream> DiskFileManager::getInputStream(const std::filesystem::path &filename,
                                                              std::uint64_t offset) {
-    return std::make_unique<FileInputStream>(filename, offset);
+    return std::make_unique<DescriptorInputStream>(descriptors_.acquire(filename), offset);
 }
 
 std::unique_ptr<OutputStream> DiskFileManager::getOutputStream(const std::filesystem::path &filename, bool append) {
-    return std::make_unique<FileOutputStream>(filename, append);
+    auto stream = std::make_unique<FileOutputStream>(filename, append);
+    if (!append) {
+        invalidateBlocks(findFileId(filename));
+    }
+    return stream;
+}
+
+void DiskFileManager::readAt(const std::filesystem::path &path,
+                             std::uint64_t offset,
+                             std::size_t length,
+                             char *dst) {
+    auto descriptor = descriptors_.acquire(path);
+    if (!blockCache_) {
+        if (descriptor->readAt(offset, length, dst) != length) {
+            throw IOException("Unable to read " + std::to_string(length) + " bytes from " + path.string());
+        }
+        return;
+    }
+    const FileId fileId = descriptor->getFileId();
+    BlockCache::Block block;
+    while (length > 0) {
+        std::uint64_t blockIndex = offset / BlockCache::BLOCK_SIZE;
+        std::size_t blockOffset = offset % BlockCache::BLOCK_SIZE;
+        std::size_t chunk = std::min(length, BlockCache::BLOCK_SIZE - blockOffset);
+        if (!blockCache_->read(fileId, blockIndex, blockOffset, chunk, dst)) {
+            const std::uint64_t epoch = blockCache_->getEpoch(fileId);
+            std::size_t wasRead = descriptor->readAt(blockIndex * BlockCache::BLOCK_SIZE,
+                                                     BlockCache::BLOCK_SIZE,
+                                                     block.data());
+            if (wasRead < blockOffset + chunk) {
+                throw IOException("Unable to read " + std::to_string(length) + " bytes from " + path.string());
+            }
+            if (wasRead == BlockCache::BLOCK_SIZE) {
+                blockCache_->insert(fileId, blockIndex, block, epoch);
+            }
+            std::memcpy(dst, block.data() + blockOffset, chunk);
+        }
+        offset += chunk;
+        length -= chunk;
+        dst += chunk;
+    }
+}
+
+bool DiskFileManager::exists(const std::filesystem::path &path) {
+    return std::filesystem::exists(path);
+}
+
+void DiskFileManager::truncate(const std::filesystem::path &path, std::uint64_t size) {
+    std::error_code error;
+    std::filesystem::resize_file(path, size, error);
+    invalidateBlocks(findFileId(path));
+    if (error) {
+        throw FileException(path, "Unable to truncate: " + error.message());
+    }
 }
 
 void DiskFileManager::remove(const std::filesystem::path &p) {
-    if (!std::filesystem::remove(p)) {
+    std::optional<FileId> removed = findFileId(p);
+    descriptors_.invalidate(p);
+    bool wasRemoved = std::filesystem::remove(p);
+    invalidateBlocks(removed);
+    if (!wasRemoved) {
         throw FileException(p, "Can not delete file");
     }
 }
 
 void DiskFileManager::rename(const std::filesystem::path &prev, const std::filesystem::path &next) {
+    std::optional<FileId> replaced = findFileId(next);
+    descriptors_.invalidate(prev);
+    descriptors_.invalidate(next);
     try {
         std::filesystem::rename(prev, next);
     } catch (const std::filesystem::filesystem_error &er) {
         throw FileException(prev, er.what());
     }
+    invalidateBlocks(replaced);
 }
 
 void DiskFileManager::swap(const std::filesystem::path &first, const std::filesystem::path &second) {
@@ -34,4 +100,18 @@ void DiskFileManager::swap(const std::filesystem::path &first, const std::filesy
     rename(temp_name, second);
 }
 
+std::optional<FileId> DiskFileManager::findFileId(const std::filesystem::path &path) const {
+    struct stat fileStat{};
+    if (!blockCache_ || ::stat(path.c_str(), &fileStat) != 0) {
+        return std::nullopt;
+    }
+    return FileId{static_cast<std::uint64_t>(fileStat.st_dev), static_cast<std::uint64_t>(fileStat.st_ino)};
+}
+
+void DiskFileManager::invalidateBlocks(const std::optional<FileId> &file) {
+    if (file.has_value()) {
+        blockCache_->invalidate(file.value());
+    }
+}
+
 } // supermap::io
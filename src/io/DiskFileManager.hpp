@@ -1,20 +1,51 @@
 #pragma once
 
+#include <optional>
+
 #include "FileManager.hpp"
+#include "FileDescriptorCache.hpp"
+#include "BlockCache.hpp"
 
 namespace supermap::io {
 
 /**
  * @brief Actual file system manager.
+ * Keeps bounded cache of opened read-only descriptors, so reading does not
+ * require to open a file every time. Positional reads may also go through
+ * the shared @p BlockCache, while streams always read the file directly,
+ * so that scans do not wash out the cache.
  */
 class DiskFileManager : public FileManager {
   public:
+    static constexpr std::size_t DEFAULT_MAX_OPEN_FILES = 32;
+
+    /**
+     * @param maxOpenFiles Maximal number of simultaneously cached read-only descriptors.
+     * @param blockCache Shared cache of file blocks used by @p readAt. No caching if @p nullptr.
+     */
+    explicit DiskFileManager(std::size_t maxOpenFiles = DEFAULT_MAX_OPEN_FILES,
+                             std::shared_ptr<BlockCache> blockCache = nullptr);
+
     //! @copydoc supermap::io::FileManager::getInputStream()
     std::unique_ptr<InputStream> getInputStream(const std::filesystem::path &filename, std::uint64_t offset) override;
 
     //! @copydoc supermap::io::FileManager::getOutputStream()
     std::unique_ptr<OutputStream> getOutputStream(const std::filesystem::path &filename, bool append) override;
 
+    /**
+     * @brief Reads @p length bytes at @p offset with a single positional read
+     * through the cached descriptor, or block by block through the block cache if there is one.
+     * Safe to be called concurrently.
+     * @copydetails supermap::io::FileManager::readAt()
+     */
+    void readAt(const std::filesystem::path &path, std::uint64_t offset, std::size_t length, char *dst) override;
+
+    //! @copydoc supermap::io::FileManager::exists()
+    bool exists(const std::filesystem::path &path) override;
+
+    //! @copydoc supermap::io::FileManager::truncate()
+    void truncate(const std::filesystem::path &path, std::uint64_t size) override;
+
     //! @copydoc supermap::io::FileManager::remove()
     void remove(const std::filesystem::path &) override;
 
@@ -23,6 +54,21 @@ class DiskFileManager : public FileManager {
 
     //! @copydoc supermap::io::FileManager::swap()
     void swap(const std::filesystem::path &first, const std::filesystem::path &second) override;
+
+  private:
+    /**
+     * @return Identity of the file @p path, if it exists and its blocks may be cached.
+     */
+    std::optional<FileId> findFileId(const std::filesystem::path &path) const;
+
+    /**
+     * @brief Drops cached blocks of the @p file, if it is known. Called after the file is changed,
+     * so that blocks, which were read before the change, are not inserted after it.
+     */
+    void invalidateBlocks(const std::optional<FileId> &file);
+
+    FileDescriptorCache descriptors_;
+    std::shared_ptr<BlockCache> blockCache_;
 };
 
 } // supermap::io
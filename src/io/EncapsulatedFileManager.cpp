@@ -23,6 +23,25 @@ std::unique_ptr<InputStream> EncapsulatedFileManager::getInputStream(const std::
     return innerManager_->getInputStream(makeRootPath(path), offset);
 }
 
+void EncapsulatedFileManager::readAt(const std::filesystem::path &path,
+                                     std::uint64_t offset,
+                                     std::size_t length,
+                                     char *dst) {
+    innerManager_->readAt(makeRootPath(path), offset, length, dst);
+}
+
+void EncapsulatedFileManager::seal(const std::filesystem::path &path) {
+    innerManager_->seal(makeRootPath(path));
+}
+
+bool EncapsulatedFileManager::exists(const std::filesystem::path &path) {
+    return innerManager_->exists(makeRootPath(path));
+}
+
+void EncapsulatedFileManager::truncate(const std::filesystem::path &path, std::uint64_t size) {
+    innerManager_->truncate(makeRootPath(path), size);
+}
+
 void EncapsulatedFileManager::remove(const std::filesystem::path &path) {
     innerManager_->remove(makeRootPath(path));
 }
@@ -32,6 +32,18 @@ class EncapsulatedFileManager : public FileManager {
     //! @copydoc supermap::io::FileManager::getOutputStream()
     std::unique_ptr<OutputStream> getOutputStream(const std::filesystem::path &path, bool append) override;
 
+    //! @copydoc supermap::io::FileManager::readAt()
+    void readAt(const std::filesystem::path &path, std::uint64_t offset, std::size_t length, char *dst) override;
+
+    //! @copydoc supermap::io::FileManager::seal()
+    void seal(const std::filesystem::path &path) override;
+
+    //! @copydoc supermap::io::FileManager::exists()
+    bool exists(const std::filesystem::path &path) override;
+
+    //! @copydoc supermap::io::FileManager::truncate()
+    void truncate(const std::filesystem::path &path, std::uint64_t size) override;
+
     //! @copydoc supermap::io::FileManager::remove()
     void remove(const std::filesystem::path &path) override;
 
@@ -0,0 +1,94 @@
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "FileDescriptorCache.hpp"
+#include "exception/FileException.hpp"
+
+namespace supermap::io {
+
+FileDescriptor::FileDescriptor(const std::filesystem::path &path)
+    : path_(path), fd_(::open(path.c_str(), O_RDONLY | O_CLOEXEC)) {
+    if (fd_ < 0) {
+        throw FileException(path, std::string("Unable to open for reading: ") + std::strerror(errno));
+    }
+    struct stat fileStat{};
+    if (::fstat(fd_, &fileStat) != 0) {
+        int error = errno;
+        ::close(fd_);
+        throw FileException(path, std::string("Unable to get file info: ") + std::strerror(error));
+    }
+    fileId_ = FileId{static_cast<std::uint64_t>(fileStat.st_dev), static_cast<std::uint64_t>(fileStat.st_ino)};
+}
+
+std::uint64_t FileDescriptor::size() const {
+    struct stat fileStat{};
+    if (::fstat(fd_, &fileStat) != 0) {
+        throw FileException(path_, std::string("Unable to get file size: ") + std::strerror(errno));
+    }
+    return fileStat.st_size;
+}
+
+std::size_t FileDescriptor::readAt(std::uint64_t offset, std::size_t length, char *dst) const {
+    std::size_t totalRead = 0;
+    while (totalRead < length) {
+        ssize_t wasRead = ::pread(fd_, dst + totalRead, length - totalRead, offset + totalRead);
+        if (wasRead < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw IOException("Unable to read " + path_.string() + ": " + std::strerror(errno));
+        }
+        if (wasRead == 0) {
+            break;
+        }
+        totalRead += wasRead;
+    }
+    return totalRead;
+}
+
+FileId FileDescriptor::getFileId() const noexcept {
+    return fileId_;
+}
+
+const std::filesystem::path &FileDescriptor::getPath() const noexcept {
+    return path_;
+}
+
+FileDescriptor::~FileDescriptor() {
+    ::close(fd_);
+}
+
+FileDescriptorCache::FileDescriptorCache(std::size_t capacity)
+    : capacity_(capacity) {}
+
+std::shared_ptr<FileDescriptor> FileDescriptorCache::acquire(const std::filesystem::path &path) {
+    if (capacity_ == 0) {
+        return std::make_shared<FileDescriptor>(path);
+    }
+    std::lock_guard lock(mutex_);
+    if (auto it = entries_.find(path.string()); it != entries_.end()) {
+        recentlyUsed_.splice(recentlyUsed_.begin(), recentlyUsed_, it->second);
+        return it->second->second;
+    }
+    auto descriptor = std::make_shared<FileDescriptor>(path);
+    recentlyUsed_.emplace_front(path.string(), descriptor);
+    entries_[path.string()] = recentlyUsed_.begin();
+    if (recentlyUsed_.size() > capacity_) {
+        entries_.erase(recentlyUsed_.back().first);
+        recentlyUsed_.pop_back();
+    }
+    return descriptor;
+}
+
+void FileDescriptorCache::invalidate(const std::filesystem::path &path) {
+    std::lock_guard lock(mutex_);
+    if (auto it = entries_.find(path.string()); it != entries_.end()) {
+        recentlyUsed_.erase(it->second);
+        entries_.erase(it);
+    }
+}
+
+} // supermap::io
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace supermap::io {
+
+/**
+ * @brief Identity of the file contents, which does not depend on the file path.
+ */
+struct FileId {
+    std::uint64_t device;
+    std::uint64_t inode;
+
+    bool operator==(const FileId &other) const noexcept {
+        return device == other.device && inode == other.inode;
+    }
+};
+
+/**
+ * @brief Read-only POSIX file descriptor. Descriptor is opened during ctor and closed with dtor.
+ */
+class FileDescriptor {
+  public:
+    /**
+     * @brief Opens file @p path for reading.
+     * @param path File to open.
+     * @throws FileException if file can not be opened.
+     */
+    explicit FileDescriptor(const std::filesystem::path &path);
+
+    FileDescriptor(const FileDescriptor &) = delete;
+    FileDescriptor &operator=(const FileDescriptor &) = delete;
+
+    /**
+     * @return Current size of the file in bytes.
+     */
+    [[nodiscard]] std::uint64_t size() const;
+
+    /**
+     * @brief Reads at most @p length bytes starting from @p offset to @p dst.
+     * Does not change any shared state, so can be called concurrently.
+     * @param offset Read begin offset.
+     * @param length Number of bytes to read.
+     * @param dst Destination buffer, at least @p length bytes long.
+     * @return Number of actually read bytes. Less then @p length only if end of file is reached.
+     * @throws IOException if read fails.
+     */
+    std::size_t readAt(std::uint64_t offset, std::size_t length, char *dst) const;
+
+    /**
+     * @return Identity of the opened file.
+     */
+    [[nodiscard]] FileId getFileId() const noexcept;
+
+    /**
+     * @return Path of the opened file.
+     */
+    [[nodiscard]] const std::filesystem::path &getPath() const noexcept;
+
+    /**
+     * @brief Closes descriptor.
+     */
+    ~FileDescriptor();
+
+  private:
+    std::filesystem::path path_;
+    int fd_;
+    FileId fileId_{};
+};
+
+/**
+ * @brief Bounded cache of opened read-only file descriptors.
+ * The least recently used descriptor is closed when cache capacity is exceeded.
+ * Descriptors are shared, so evicted descriptor stays opened while someone still reads from it.
+ * All methods are thread-safe.
+ */
+class FileDescriptorCache {
+  public:
+    /**
+     * @param capacity Maximal number of simultaneously cached descriptors.
+     */
+    explicit FileDescriptorCache(std::size_t capacity);
+
+    /**
+     * @brief Gets cached descriptor of @p path, opening it if it is absent in cache.
+     * @param path File path.
+     * @return Shared access to the descriptor.
+     */
+    std::shared_ptr<FileDescriptor> acquire(const std::filesystem::path &path);
+
+    /**
+     * @brief Drops cached descriptor of @p path, if any. Must be called every time
+     * @p path starts to point to the other file.
+     * @param path File path.
+     */
+    void invalidate(const std::filesystem::path &path);
+
+  private:
+    using Entry = std::pair<std::string, std::shared_ptr<FileDescriptor>>;
+
+    const std::size_t capacity_;
+    std::list<Entry> recentlyUsed_;
+    std::unordered_map<std::string, std::list<Entry>::iterator> entries_;
+    std::mutex mutex_;
+};
+
+} // supermap::io
@@ -30,6 +30,43 @@ class FileManager {
      */
     virtual std::unique_ptr<OutputStream> getOutputStream(const std::filesystem::path &path, bool append) = 0;
 
+    /**
+     * @brief Reads exactly @p length bytes of file @p path starting from @p offset to @p dst.
+     * Implementations are expected to allow concurrent calls.
+     * @param path File to read from.
+     * @param offset Reading begin offset.
+     * @param length Number of bytes to read.
+     * @param dst Destination buffer, at least @p length bytes long.
+     * @throws IOException if less then @p length bytes are available.
+     */
+    virtual void readAt(const std::filesystem::path &path, std::uint64_t offset, std::size_t length, char *dst) {
+        auto input = getInputStream(path, offset);
+        if (input->availableBytes() < length) {
+            throw IOException("Unable to read " + std::to_string(length) + " bytes from " + path.string());
+        }
+        input->get().read(dst, static_cast<std::streamsize>(length));
+    }
+
+    /**
+     * @brief Tells that file @p path is complete and will only be read, until it is
+     * truncated, overwritten or removed. Managers may serve reads of such files differently.
+     * @param path Complete file path.
+     */
+    virtual void seal(const std::filesystem::path &) {}
+
+    /**
+     * @param path File path.
+     * @return If file @p path exists.
+     */
+    virtual bool exists(const std::filesystem::path &path) = 0;
+
+    /**
+     * @brief Cuts file @p path to @p size bytes.
+     * @param path File to truncate.
+     * @param size New file size, not greater than the current one.
+     */
+    virtual void truncate(const std::filesystem::path &path, std::uint64_t size) = 0;
+
     /**
      * @brief Removes @p path file from file system.
      * Guaranteed that file won't be in the file system after call.
@@ -40,6 +77,7 @@ class FileManager {
     /**
      * @brief Renames file form @p prevPath to @p nextPath.
      * @p prevPath must be already in file system to perform this action.
+     * If @p nextPath exists, it is atomically replaced.
      * @param prevPath Previous file name.
      * @param nextPath Next file name.
      */
@@ -62,6 +100,14 @@ class FileManager {
         getOutputStream(path, false)->flush();
     }
 
+    /**
+     * @brief Makes all data written to the file @p path durable.
+     * @param path File to synchronize.
+     */
+    void sync(const std::filesystem::path &path) {
+        getOutputStream(path, true)->sync();
+    }
+
     /**
      * @brief Swaps contents of files.
      * @param first First file path.
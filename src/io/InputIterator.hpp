@@ -107,9 +107,9 @@ class InputIterator {
         const std::uint64_t bytesToRead = static_cast<std::uint64_t>(objectsToRead) * EachSize;
         std::unique_ptr<char[]> bytes = std::make_unique<char[]>(bytesToRead);
         input_->get().read(bytes.get(), bytesToRead);
-        std::stringstream iss(std::string(bytes.get(), bytesToRead), std::ios_base::in);
-        for (IndexT objectI = 0; objectI < objectsToRead; ++objectI) {
-            collection.push_back(functor(deserialize<T>(iss), index_++));
+        const char *src = bytes.get();
+        for (IndexT objectI = 0; objectI < objectsToRead; ++objectI, src += EachSize) {
+            collection.push_back(functor(deserializeFrom<T>(src), index_++));
         }
         return collection;
     }
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cstring>
 #include <filesystem>
 
 #include "InputStream.hpp"
@@ -22,6 +24,119 @@ std::size_t FileInputStream::availableBytes() {
     return fileSize_ - ifs_.tellg();
 }
 
+DescriptorStreamBuffer::DescriptorStreamBuffer(std::shared_ptr<FileDescriptor> descriptor,
+                                               std::uint64_t fileSize,
+                                               std::uint64_t offset)
+    : descriptor_(std::move(descriptor)),
+      fileSize_(fileSize),
+      bufferOffset_(offset) {
+    setg(buffer_.data(), buffer_.data(), buffer_.data());
+}
+
+std::uint64_t DescriptorStreamBuffer::getFileSize() const noexcept {
+    return fileSize_;
+}
+
+std::uint64_t DescriptorStreamBuffer::position() const noexcept {
+    return bufferOffset_ + (gptr() - eback());
+}
+
+DescriptorStreamBuffer::int_type DescriptorStreamBuffer::underflow() {
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+    std::uint64_t pos = position();
+    if (pos >= fileSize_) {
+        return traits_type::eof();
+    }
+    std::size_t toRead = std::min<std::uint64_t>(nextReadSize_, fileSize_ - pos);
+    if (buffer_.size() < toRead) {
+        buffer_.resize(toRead);
+    }
+    std::size_t wasRead = descriptor_->readAt(pos, toRead, buffer_.data());
+    nextReadSize_ = std::min(nextReadSize_ * 2, MAX_READ_SIZE);
+    bufferOffset_ = pos;
+    setg(buffer_.data(), buffer_.data(), buffer_.data() + wasRead);
+    if (wasRead == 0) {
+        return traits_type::eof();
+    }
+    return traits_type::to_int_type(*gptr());
+}
+
+std::streamsize DescriptorStreamBuffer::xsgetn(char_type *s, std::streamsize count) {
+    std::streamsize done = 0;
+    while (done < count) {
+        std::streamsize available = egptr() - gptr();
+        if (available > 0) {
+            std::streamsize taken = std::min(available, count - done);
+            std::memcpy(s + done, gptr(), taken);
+            gbump(static_cast<int>(taken));
+            done += taken;
+            continue;
+        }
+        if (static_cast<std::size_t>(count - done) >= MAX_READ_SIZE) {
+            std::uint64_t pos = position();
+            std::size_t wasRead = descriptor_->readAt(pos, count - done, s + done);
+            bufferOffset_ = pos + wasRead;
+            setg(buffer_.data(), buffer_.data(), buffer_.data());
+            done += static_cast<std::streamsize>(wasRead);
+            if (wasRead == 0) {
+                break;
+            }
+            continue;
+        }
+        if (traits_type::eq_int_type(underflow(), traits_type::eof())) {
+            break;
+        }
+    }
+    return done;
+}
+
+DescriptorStreamBuffer::pos_type DescriptorStreamBuffer::seekoff(off_type off,
+                                                                 std::ios_base::seekdir dir,
+                                                                 std::ios_base::openmode which) {
+    off_type target;
+    if (dir == std::ios_base::beg) {
+        target = off;
+    } else if (dir == std::ios_base::cur) {
+        target = static_cast<off_type>(position()) + off;
+    } else {
+        target = static_cast<off_type>(fileSize_) + off;
+    }
+    return seekpos(pos_type(target), which);
+}
+
+DescriptorStreamBuffer::pos_type DescriptorStreamBuffer::seekpos(pos_type pos, std::ios_base::openmode which) {
+    off_type target = pos;
+    if (!(which & std::ios_base::in) || target < 0 || static_cast<std::uint64_t>(target) > fileSize_) {
+        return pos_type(off_type(-1));
+    }
+    std::uint64_t absolute = target;
+    if (absolute >= bufferOffset_ && absolute <= bufferOffset_ + (egptr() - eback())) {
+        setg(eback(), eback() + (absolute - bufferOffset_), egptr());
+    } else {
+        bufferOffset_ = absolute;
+        setg(buffer_.data(), buffer_.data(), buffer_.data());
+    }
+    return pos;
+}
+
+DescriptorInputStream::DescriptorInputStream(std::shared_ptr<FileDescriptor> descriptor, std::uint64_t offset)
+    : buffer_(descriptor, descriptor->size(), offset),
+      stream_(&buffer_) {}
+
+std::istream &DescriptorInputStream::get() {
+    return stream_;
+}
+
+std::size_t DescriptorInputStream::availableBytes() {
+    auto pos = stream_.tellg();
+    if (pos == -1 || static_cast<std::uint64_t>(pos) >= buffer_.getFileSize()) {
+        return 0;
+    }
+    return buffer_.getFileSize() - pos;
+}
+
 StringInputStream::StringInputStream(const std::string &str, std::uint64_t offset)
     : stringStream_(str.substr(offset, str.size() - offset)),
       initialPos_(stringStream_.tellg()),
@@ -4,6 +4,9 @@
 #include <sstream>
 #include <exception/FileException.hpp>
 #include <filesystem>
+#include <vector>
+
+#include "FileDescriptorCache.hpp"
 
 namespace supermap::io {
 
@@ -51,6 +54,78 @@ class FileInputStream : public InputStream {
     std::uint64_t fileSize_;
 };
 
+/**
+ * @brief Stream buffer which reads file through shared @p FileDescriptor with positional reads.
+ * Never changes descriptor state, so many buffers can read through the same descriptor.
+ */
+class DescriptorStreamBuffer : public std::streambuf {
+  public:
+    /**
+     * @param descriptor Shared access to the descriptor to read from.
+     * @param fileSize Size of the file at the moment of stream creation.
+     * @param offset Read begin offset.
+     */
+    explicit DescriptorStreamBuffer(std::shared_ptr<FileDescriptor> descriptor,
+                                    std::uint64_t fileSize,
+                                    std::uint64_t offset);
+
+    /**
+     * @return Size of underlying file.
+     */
+    [[nodiscard]] std::uint64_t getFileSize() const noexcept;
+
+  protected:
+    int_type underflow() override;
+
+    std::streamsize xsgetn(char_type *s, std::streamsize count) override;
+
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+
+  private:
+    static constexpr std::size_t INITIAL_READ_SIZE = 4096;
+    static constexpr std::size_t MAX_READ_SIZE = 64 * 1024;
+
+    [[nodiscard]] std::uint64_t position() const noexcept;
+
+    std::shared_ptr<FileDescriptor> descriptor_;
+    std::uint64_t fileSize_;
+    std::uint64_t bufferOffset_;
+    std::size_t nextReadSize_ = INITIAL_READ_SIZE;
+
+    /**
+     * @brief Grows with the read size, so that short reads do not allocate the largest buffer.
+     */
+    std::vector<char> buffer_;
+};
+
+/**
+ * @brief Specialization of InputStream which reads file through shared @p FileDescriptor.
+ * Unlike @p FileInputStream, does not open file by itself, so it is cheap to create.
+ */
+class DescriptorInputStream : public InputStream {
+  public:
+    /**
+     * @brief Creates new input stream over @p descriptor with offset @p offset.
+     * @param descriptor Shared access to the descriptor to read from.
+     * @param offset Read begin offset.
+     */
+    explicit DescriptorInputStream(std::shared_ptr<FileDescriptor> descriptor, std::uint64_t offset);
+
+    /**
+     * @return Reference at actual stream, which reads from @p DescriptorStreamBuffer.
+     */
+    std::istream &get() override;
+
+    //! @copydoc supermap::io::InputStream::availableBytes()
+    std::size_t availableBytes() override;
+
+  private:
+    DescriptorStreamBuffer buffer_;
+    std::istream stream_;
+};
+
 /**
  * @brief Specialization of InputStream which encapsulates work with @p std::stringstream.
  * Dedicated to work with strings as input buffers.
@@ -0,0 +1,46 @@
+#include "MemoryStreamBuffer.hpp"
+
+namespace supermap::io {
+
+MemoryStreamBuffer::MemoryStreamBuffer(const char *data, std::size_t length) {
+    char *begin = const_cast<char *>(data);
+    setg(begin, begin, begin + length);
+}
+
+MemoryStreamBuffer::MemoryStreamBuffer(char *data, std::size_t length) {
+    setg(data, data, data + length);
+    setp(data, data + length);
+}
+
+MemoryStreamBuffer::pos_type MemoryStreamBuffer::seekoff(off_type off,
+                                                         std::ios_base::seekdir dir,
+                                                         std::ios_base::openmode which) {
+    off_type target;
+    if (dir == std::ios_base::beg) {
+        target = off;
+    } else if (dir == std::ios_base::cur) {
+        target = ((which & std::ios_base::in) ? gptr() - eback() : pptr() - pbase()) + off;
+    } else {
+        target = (egptr() - eback()) + off;
+    }
+    return seekpos(pos_type(target), which);
+}
+
+MemoryStreamBuffer::pos_type MemoryStreamBuffer::seekpos(pos_type pos, std::ios_base::openmode which) {
+    off_type target = pos;
+    const bool seekIn = which & std::ios_base::in;
+    const bool seekOut = (which & std::ios_base::out) && pbase() != nullptr;
+    if ((!seekIn && !seekOut) || target < 0 || target > egptr() - eback()) {
+        return pos_type(off_type(-1));
+    }
+    if (seekIn) {
+        setg(eback(), eback() + target, egptr());
+    }
+    if (seekOut) {
+        setp(pbase(), epptr());
+        pbump(static_cast<int>(target));
+    }
+    return pos;
+}
+
+} // supermap::io
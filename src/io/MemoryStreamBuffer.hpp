@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <streambuf>
+
+namespace supermap::io {
+
+/**
+ * @brief Stream buffer over caller-owned memory. Does not copy or own the data,
+ * so it is a cheap way to serialize objects to the raw bytes and deserialize them back.
+ */
+class MemoryStreamBuffer : public std::streambuf {
+  public:
+    /**
+     * @brief Creates read-only buffer.
+     * @param data Beginning of the memory to read from. Must outlive the buffer.
+     * @param length Number of bytes available to read.
+     */
+    MemoryStreamBuffer(const char *data, std::size_t length);
+
+    /**
+     * @brief Creates buffer, which reads and writes the same memory.
+     * @param data Beginning of the memory. Must outlive the buffer.
+     * @param length Number of bytes available to read and write.
+     */
+    MemoryStreamBuffer(char *data, std::size_t length);
+
+  protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+};
+
+} // supermap::io
@@ -0,0 +1,115 @@
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "MmapFileManager.hpp"
+
+namespace supermap::io {
+
+MappedFile::MappedFile(const std::filesystem::path &path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw FileException(path, std::string("Unable to open for reading: ") + std::strerror(errno));
+    }
+    struct stat fileStat{};
+    if (::fstat(fd, &fileStat) != 0) {
+        int error = errno;
+        ::close(fd);
+        throw FileException(path, std::string("Unable to get file size: ") + std::strerror(error));
+    }
+    size_ = fileStat.st_size;
+    if (size_ != 0) {
+        void *mapped = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED) {
+            int error = errno;
+            ::close(fd);
+            throw FileException(path, std::string("Unable to map: ") + std::strerror(error));
+        }
+        ::madvise(mapped, size_, MADV_RANDOM);
+        data_ = static_cast<const char *>(mapped);
+    }
+    ::close(fd);
+}
+
+const char *MappedFile::data() const noexcept {
+    return data_;
+}
+
+std::size_t MappedFile::size() const noexcept {
+    return size_;
+}
+
+MappedFile::~MappedFile() {
+    if (data_) {
+        ::munmap(const_cast<char *>(data_), size_);
+    }
+}
+
+MmapFileManager::MmapFileManager(std::size_t maxOpenFiles, std::shared_ptr<BlockCache> blockCache)
+    : DiskFileManager(maxOpenFiles, std::move(blockCache)) {}
+
+std::unique_ptr<OutputStream> MmapFileManager::getOutputStream(const std::filesystem::path &filename, bool append) {
+    invalidate(filename);
+    return DiskFileManager::getOutputStream(filename, append);
+}
+
+void MmapFileManager::readAt(const std::filesystem::path &path,
+                             std::uint64_t offset,
+                             std::size_t length,
+                             char *dst) {
+    {
+        std::shared_lock lock(mutex_);
+        if (auto it = mappings_.find(path.string()); it != mappings_.end()) {
+            const MappedFile &mapping = *it->second;
+            if (offset <= mapping.size() && length <= mapping.size() - offset) {
+                if (length != 0) {
+                    std::memcpy(dst, mapping.data() + offset, length);
+                }
+                return;
+            }
+        }
+    }
+    DiskFileManager::readAt(path, offset, length, dst);
+}
+
+void MmapFileManager::seal(const std::filesystem::path &path) {
+    auto mapping = std::make_shared<const MappedFile>(path);
+    std::unique_lock lock(mutex_);
+    mappings_.insert_or_assign(path.string(), std::move(mapping));
+}
+
+void MmapFileManager::truncate(const std::filesystem::path &path, std::uint64_t size) {
+    invalidate(path);
+    DiskFileManager::truncate(path, size);
+}
+
+void MmapFileManager::remove(const std::filesystem::path &p) {
+    invalidate(p);
+    DiskFileManager::remove(p);
+}
+
+void MmapFileManager::rename(const std::filesystem::path &prev, const std::filesystem::path &next) {
+    invalidate(next);
+    std::shared_ptr<const MappedFile> mapping = invalidate(prev);
+    DiskFileManager::rename(prev, next);
+    if (mapping) {
+        std::unique_lock lock(mutex_);
+        mappings_.insert_or_assign(next.string(), std::move(mapping));
+    }
+}
+
+std::shared_ptr<const MappedFile> MmapFileManager::invalidate(const std::filesystem::path &path) {
+    std::unique_lock lock(mutex_);
+    auto it = mappings_.find(path.string());
+    if (it == mappings_.end()) {
+        return nullptr;
+    }
+    std::shared_ptr<const MappedFile> mapping = std::move(it->second);
+    mappings_.erase(it);
+    return mapping;
+}
+
+} // supermap::io
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "DiskFileManager.hpp"
+
+namespace supermap::io {
+
+/**
+ * @brief Read-only shared memory mapping of the whole file.
+ * Mapping is created during ctor and released with dtor.
+ */
+class MappedFile {
+  public:
+    /**
+     * @brief Maps file @p path to memory, advising kernel that access is random,
+     * since mappings serve only point reads.
+     * @param path File to map.
+     * @throws FileException if file can not be opened or mapped.
+     */
+    explicit MappedFile(const std::filesystem::path &path);
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /**
+     * @return Beginning of the mapped file. @p nullptr if file is empty.
+     */
+    [[nodiscard]] const char *data() const noexcept;
+
+    /**
+     * @return Size of the file at the moment of mapping.
+     */
+    [[nodiscard]] std::size_t size() const noexcept;
+
+    /**
+     * @brief Unmaps file.
+     */
+    ~MappedFile();
+
+  private:
+    const char *data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+/**
+ * @brief Disk file manager, which serves positional reads of sealed files from the read-only memory mappings.
+ * Sealed files, like sorted runs and the sorted data file, are mapped once, so that point reads
+ * from them make no system calls and take only a shared lock. Files, which are still being appended,
+ * are read with positional reads through the cached descriptors. Mapping is dropped when its file is written,
+ * truncated or removed, and follows the file when it is renamed.
+ * Streams are not served from the mappings: they always read files through descriptors, so sequential scans,
+ * like data iterators and @p InputIterator::collect, keep the kernel readahead, and the mappings keep
+ * the random access advice for point reads. Scans of mapped files thus still make system calls.
+ */
+class MmapFileManager : public DiskFileManager {
+  public:
+    /**
+     * @param maxOpenFiles Maximal number of simultaneously cached read-only descriptors.
+     * @param blockCache Shared cache of blocks of files, which are not mapped. No caching if @p nullptr.
+     */
+    explicit MmapFileManager(std::size_t maxOpenFiles = DEFAULT_MAX_OPEN_FILES,
+                             std::shared_ptr<BlockCache> blockCache = nullptr);
+
+    /**
+     * @brief Drops mapping of the file, since it is going to be changed.
+     * @copydetails supermap::io::FileManager::getOutputStream()
+     */
+    std::unique_ptr<OutputStream> getOutputStream(const std::filesystem::path &filename, bool append) override;
+
+    /**
+     * @brief Copies @p length bytes at @p offset from the mapping, if file is sealed,
+     * or reads them through the cached descriptor and the block cache otherwise.
+     * Safe to be called concurrently.
+     * @copydetails supermap::io::FileManager::readAt()
+     */
+    void readAt(const std::filesystem::path &path, std::uint64_t offset, std::size_t length, char *dst) override;
+
+    /**
+     * @brief Maps the whole file @p path, so that it is read from the mapping from now on.
+     * @copydetails supermap::io::FileManager::seal()
+     * @throws FileException if file can not be opened or mapped.
+     */
+    void seal(const std::filesystem::path &path) override;
+
+    //! @copydoc supermap::io::FileManager::truncate()
+    void truncate(const std::filesystem::path &path, std::uint64_t size) override;
+
+    //! @copydoc supermap::io::FileManager::remove()
+    void remove(const std::filesystem::path &) override;
+
+    //! @copydoc supermap::io::FileManager::rename()
+    void rename(const std::filesystem::path &prev, const std::filesystem::path &next) override;
+
+  private:
+    /**
+     * @brief Drops mapping of @p path, if any.
+     * @return Dropped mapping.
+     */
+    std::shared_ptr<const MappedFile> invalidate(const std::filesystem::path &path);
+
+    std::unordered_map<std::string, std::shared_ptr<const MappedFile>> mappings_;
+    std::shared_mutex mutex_;
+};
+
+} // supermap::io
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <iterator>
 #include <memory>
+#include <vector>
 
 #include "OutputStream.hpp"
 #include "SerializeHelper.hpp"
@@ -52,7 +54,8 @@ class OutputIterator {
     }
 
     /**
-     * @brief Writes all objects from iterator @p begin to iterator @p end.
+     * @brief Writes all objects from iterator @p begin to iterator @p end with a single write.
+     * If @p T has fixed serialized size, objects are serialized directly to the raw memory buffer.
      * @tparam Iterator Type of iterator.
      * @tparam Functor Type of function which is applied to every object before writing.
      * @param begin Collection begin iterator.
@@ -68,11 +71,21 @@ class OutputIterator {
                                                 typename std::iterator_traits<Iterator>::value_type>>>
     >
     void writeAll(Iterator begin, Iterator end, Functor f) {
-        std::stringstream stringStream;
-        for (auto it = begin; it < end; ++it) {
-            serialize(f(*it), stringStream);
+        if constexpr (HasFixedDeserializedSize<T>::value) {
+            constexpr std::size_t eachSize = FixedDeserializedSizeRegister<T>::exactDeserializedSize;
+            std::vector<char> buffer(static_cast<std::size_t>(std::distance(begin, end)) * eachSize);
+            char *dst = buffer.data();
+            for (auto it = begin; it < end; ++it, dst += eachSize) {
+                serializeTo(f(*it), dst);
+            }
+            os_->get().write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        } else {
+            std::stringstream stringStream;
+            for (auto it = begin; it < end; ++it) {
+                serialize(f(*it), stringStream);
+            }
+            os_->get() << stringStream.rdbuf();
         }
-        os_->get() << stringStream.rdbuf();
     }
 
     /**
@@ -1,3 +1,8 @@
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
 #include "OutputStream.hpp"
 
 namespace supermap::io {
@@ -13,10 +18,32 @@ void FileOutputStream::flush() {
     ofs_.flush();
 }
 
+void FileOutputStream::sync() {
+    flush();
+    if (!ofs_.good()) {
+        throw FileException(filename_, "Unable to write");
+    }
+    if (syncFd_ < 0) {
+        syncFd_ = ::open(filename_.c_str(), O_WRONLY | O_CLOEXEC);
+        if (syncFd_ < 0) {
+            throw FileException(filename_, std::string("Unable to open for sync: ") + std::strerror(errno));
+        }
+    }
+    if (::fdatasync(syncFd_) != 0) {
+        throw FileException(filename_, std::string("Unable to sync: ") + std::strerror(errno));
+    }
+}
+
 std::ostream &FileOutputStream::get() {
     return ofs_;
 }
 
+FileOutputStream::~FileOutputStream() {
+    if (syncFd_ >= 0) {
+        ::close(syncFd_);
+    }
+}
+
 StringOutputStream::StringOutputStream(std::string &buffer, bool append)
     : buffer_(buffer) {
     if (!append) {
@@ -30,6 +57,7 @@ std::ostream &StringOutputStream::get() {
 
 void StringOutputStream::flush() {
     buffer_ += stringStream_.str();
+    stringStream_.str("");
     stringStream_.clear();
 }
 
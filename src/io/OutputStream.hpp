@@ -22,6 +22,15 @@ class OutputStream {
      */
     virtual void flush() = 0;
 
+    /**
+     * @brief Flushes output stream and makes all written data durable,
+     * so it survives the crash of the process or the whole system.
+     * Same as @p flush for streams which are not backed by the persistent storage.
+     */
+    virtual void sync() {
+        flush();
+    }
+
     virtual ~OutputStream() = default;
 };
 
@@ -40,12 +49,24 @@ class FileOutputStream : public OutputStream {
     //! @copydoc OutputStream::flush()
     void flush() override;
 
+    /**
+     * @brief Flushes output stream and waits until file data reaches the disk with @p fdatasync.
+     * @throws FileException if file can not be synchronized.
+     */
+    void sync() override;
+
     //! @copydoc OutputStream::get()
     std::ostream &get() override;
 
+    /**
+     * @brief Closes the file.
+     */
+    ~FileOutputStream() override;
+
   private:
     const std::string filename_;
     std::ofstream ofs_;
+    int syncFd_ = -1;
 };
 
 class StringOutputStream : public OutputStream {
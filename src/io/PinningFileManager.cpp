@@ -0,0 +1,80 @@
+#include "PinningFileManager.hpp"
+#include "exception/IllegalStateException.hpp"
+
+namespace supermap::io {
+
+PinningFileManager::PinningFileManager(std::unique_ptr<FileManager> &&innerManager)
+    : innerManager_(std::move(innerManager)) {}
+
+void PinningFileManager::pin(std::unordered_set<std::string> paths) {
+    std::lock_guard lock(mutex_);
+    pinned_ = std::move(paths);
+    for (auto it = postponed_.begin(); it != postponed_.end();) {
+        if (pinned_.count(*it) == 0) {
+            innerManager_->remove(*it);
+            it = postponed_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+std::unique_ptr<InputStream> PinningFileManager::getInputStream(const std::filesystem::path &path,
+                                                                std::uint64_t offset) {
+    return innerManager_->getInputStream(path, offset);
+}
+
+std::unique_ptr<OutputStream> PinningFileManager::getOutputStream(const std::filesystem::path &path, bool append) {
+    return innerManager_->getOutputStream(path, append);
+}
+
+void PinningFileManager::readAt(const std::filesystem::path &path,
+                                std::uint64_t offset,
+                                std::size_t length,
+                                char *dst) {
+    innerManager_->readAt(path, offset, length, dst);
+}
+
+void PinningFileManager::seal(const std::filesystem::path &path) {
+    innerManager_->seal(path);
+}
+
+bool PinningFileManager::exists(const std::filesystem::path &path) {
+    return innerManager_->exists(path);
+}
+
+void PinningFileManager::truncate(const std::filesystem::path &path, std::uint64_t size) {
+    innerManager_->truncate(path, size);
+}
+
+void PinningFileManager::remove(const std::filesystem::path &path) {
+    {
+        std::lock_guard lock(mutex_);
+        if (pinned_.count(path.string()) != 0) {
+            postponed_.insert(path.string());
+            return;
+        }
+    }
+    innerManager_->remove(path);
+}
+
+void PinningFileManager::rename(const std::filesystem::path &prevPath, const std::filesystem::path &nextPath) {
+    checkNotPinned(prevPath);
+    checkNotPinned(nextPath);
+    innerManager_->rename(prevPath, nextPath);
+}
+
+void PinningFileManager::swap(const std::filesystem::path &a, const std::filesystem::path &b) {
+    checkNotPinned(a);
+    checkNotPinned(b);
+    innerManager_->swap(a, b);
+}
+
+void PinningFileManager::checkNotPinned(const std::filesystem::path &path) {
+    std::lock_guard lock(mutex_);
+    if (pinned_.count(path.string()) != 0) {
+        throw IllegalStateException("Pinned file " + path.string() + " can not be renamed");
+    }
+}
+
+} // supermap::io
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <mutex>
+#include <unordered_set>
+
+#include "FileManager.hpp"
+
+namespace supermap::io {
+
+/**
+ * @brief Capsule for other @p FileManager, which keeps pinned files in place.
+ * Removal of pinned file is postponed until the file is unpinned, so files which
+ * are referenced by a persistent manifest survive until the next manifest stops referencing them.
+ * Pinned files must not be renamed or swapped. All methods are thread-safe
+ * as long as the inner manager is.
+ */
+class PinningFileManager : public FileManager {
+  public:
+    /**
+     * @param innerManager Manager to delegate all requests to.
+     */
+    explicit PinningFileManager(std::unique_ptr<FileManager> &&innerManager);
+
+    /**
+     * @brief Replaces the set of pinned files with @p paths. Files, which removal was postponed,
+     * and which are not pinned anymore, are removed.
+     * @param paths New set of pinned files.
+     */
+    void pin(std::unordered_set<std::string> paths);
+
+    //! @copydoc supermap::io::FileManager::getInputStream()
+    std::unique_ptr<InputStream> getInputStream(const std::filesystem::path &path, std::uint64_t offset) override;
+
+    //! @copydoc supermap::io::FileManager::getOutputStream()
+    std::unique_ptr<OutputStream> getOutputStream(const std::filesystem::path &path, bool append) override;
+
+    //! @copydoc supermap::io::FileManager::readAt()
+    void readAt(const std::filesystem::path &path, std::uint64_t offset, std::size_t length, char *dst) override;
+
+    //! @copydoc supermap::io::FileManager::seal()
+    void seal(const std::filesystem::path &path) override;
+
+    //! @copydoc supermap::io::FileManager::exists()
+    bool exists(const std::filesystem::path &path) override;
+
+    //! @copydoc supermap::io::FileManager::truncate()
+    void truncate(const std::filesystem::path &path, std::uint64_t size) override;
+
+    /**
+     * @brief Removes file @p path, or postpones removal if it is pinned.
+     * @param path Removed file path.
+     */
+    void remove(const std::filesystem::path &path) override;
+
+    /**
+     * @copydoc supermap::io::FileManager::rename()
+     * @throws IllegalStateException if any of files is pinned.
+     */
+    void rename(const std::filesystem::path &prevPath, const std::filesystem::path &nextPath) override;
+
+    /**
+     * @copydoc supermap::io::FileManager::swap()
+     * @throws IllegalStateException if any of files is pinned.
+     */
+    void swap(const std::filesystem::path &a, const std::filesystem::path &b) override;
+
+  private:
+    /**
+     * @throws IllegalStateException if @p path is pinned.
+     */
+    void checkNotPinned(const std::filesystem::path &path);
+
+    std::unique_ptr<FileManager> innerManager_;
+    std::unordered_set<std::string> pinned_;
+    std::unordered_set<std::string> postponed_;
+    std::mutex mutex_;
+};
+
+} // supermap::io
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <cstring>
 
 #include "RamFileManager.hpp"
 #include "exception/FileException.hpp"
@@ -30,6 +31,25 @@ std::unique_ptr<OutputStream> RamFileManager::getOutputStream(const std::filesys
     return std::make_unique<StringOutputStream>(files[fileIndex].content, append);
 }
 
+void RamFileManager::readAt(const std::filesystem::path &path,
+                            std::uint64_t offset,
+                            std::size_t length,
+                            char *dst) {
+    const std::string &content = getFileIterator(path)->content;
+    if (offset > content.size() || length > content.size() - offset) {
+        throw IOException("Unable to read " + std::to_string(length) + " bytes from " + path.string());
+    }
+    std::memcpy(dst, content.data() + offset, length);
+}
+
+bool RamFileManager::exists(const std::filesystem::path &path) {
+    return getFileIteratorNoThrow(path) != files.end();
+}
+
+void RamFileManager::truncate(const std::filesystem::path &path, std::uint64_t size) {
+    accessFile(getFileIterator(path)).content.resize(size);
+}
+
 void RamFileManager::remove(const std::filesystem::path &path) {
     auto fileIt = getFileIterator(path);
     std::size_t fileIndex = fileIt - files.begin();
@@ -38,7 +58,11 @@ void RamFileManager::remove(const std::filesystem::path &path) {
 }
 
 void RamFileManager::rename(const std::filesystem::path &prev, const std::filesystem::path &next) {
-    accessFile(getFileIterator(prev)).name = next;
+    auto prevIt = getFileIterator(prev);
+    if (prev != next && exists(next)) {
+        remove(next);
+    }
+    accessFile(prevIt).name = next;
 }
 
 void RamFileManager::swap(const std::filesystem::path &first, const std::filesystem::path &second) {
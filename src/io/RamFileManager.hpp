@@ -25,6 +25,15 @@ class RamFileManager : public FileManager {
     //! @copydoc InputStream::getOutputStream()
     std::unique_ptr<OutputStream> getOutputStream(const std::filesystem::path &filename, bool append) override;
 
+    //! @copydoc FileManager::readAt()
+    void readAt(const std::filesystem::path &path, std::uint64_t offset, std::size_t length, char *dst) override;
+
+    //! @copydoc FileManager::exists()
+    bool exists(const std::filesystem::path &path) override;
+
+    //! @copydoc FileManager::truncate()
+    void truncate(const std::filesystem::path &path, std::uint64_t size) override;
+
     //! @copydoc InputStream::remove()
     void remove(const std::filesystem::path &path) override;
 
@@ -5,6 +5,7 @@
 #include <istream>
 
 #include "exception/SupermapException.hpp"
+#include "MemoryStreamBuffer.hpp"
 
 namespace supermap::io {
 
@@ -45,6 +46,17 @@ struct FixedDeserializedSize {
 template <typename T, typename = void>
 struct FixedDeserializedSizeRegister {};
 
+/**
+ * @brief Tells if @p FixedDeserializedSizeRegister is declared for @p T.
+ * @tparam T Checked type.
+ */
+template <typename T, typename = void>
+struct HasFixedDeserializedSize : std::false_type {};
+
+template <typename T>
+struct HasFixedDeserializedSize<T, std::void_t<decltype(FixedDeserializedSizeRegister<T>::exactDeserializedSize)>>
+    : std::true_type {};
+
 /**
  * @brief Container for @p serialize function. Must be declared
  * for any type that wants to be serialized.
@@ -58,6 +70,20 @@ struct SerializeHelper : Serializable<false> {
     }
 };
 
+/**
+ * @brief Tells if @p SerializeHelper of @p T can serialize directly to the memory
+ * with static @p serializeTo(const T &, char *) function.
+ * @tparam T Checked type.
+ */
+template <typename T, typename = void>
+struct HasSerializeTo : std::false_type {};
+
+template <typename T>
+struct HasSerializeTo<
+    T,
+    std::void_t<decltype(SerializeHelper<T>::serializeTo(std::declval<const T &>(), std::declval<char *>()))>
+> : std::true_type {};
+
 /**
  * @brief Container for @p deserialize function. Must be declared
  * for any type that wants to be deserialized.
@@ -71,6 +97,18 @@ struct DeserializeHelper : Deserializable<false> {
     }
 };
 
+/**
+ * @brief Tells if @p DeserializeHelper of @p T can deserialize directly from the memory
+ * with static @p deserializeFrom(const char *) function.
+ * @tparam T Checked type.
+ */
+template <typename T, typename = void>
+struct HasDeserializeFrom : std::false_type {};
+
+template <typename T>
+struct HasDeserializeFrom<T, std::void_t<decltype(DeserializeHelper<T>::deserializeFrom(std::declval<const char *>()))>>
+    : std::true_type {};
+
 /**
  * @brief Serializes @p value to the output stream @p os using @p SerializeHelper::serialize.
  * @tparam T type of serialized object.
@@ -95,4 +133,44 @@ inline T deserialize(std::istream &is) {
     return DeserializeHelper<T>::deserialize(is);
 }
 
+/**
+ * @brief Serializes @p value to the memory @p dst, which must be at least
+ * @p FixedDeserializedSizeRegister<T>::exactDeserializedSize bytes long.
+ * Uses @p SerializeHelper::serializeTo if it is declared, and @p SerializeHelper::serialize otherwise.
+ * @tparam T type of serialized object.
+ * @param value Object to serialize.
+ * @param dst Serialization destination.
+ */
+template <typename T, typename = std::enable_if_t<SerializeHelper<T>::isSerializable>>
+inline void serializeTo(const T &value, char *dst) {
+    if constexpr (HasSerializeTo<T>::value) {
+        SerializeHelper<T>::serializeTo(value, dst);
+    } else {
+        MemoryStreamBuffer buffer(dst, FixedDeserializedSizeRegister<T>::exactDeserializedSize);
+        std::ostream os(&buffer);
+        SerializeHelper<T>::serialize(value, os);
+    }
+}
+
+/**
+ * @brief Deserializes object of type @p T from the memory @p src, which must be at least
+ * @p FixedDeserializedSizeRegister<T>::exactDeserializedSize bytes long.
+ * Uses @p DeserializeHelper::deserializeFrom if it is declared, and @p DeserializeHelper::deserialize otherwise.
+ * @tparam T type of deserialized object.
+ * @param src Serialized object memory.
+ * @return Deserialized object.
+ */
+template <
+    typename T,
+    typename = std::enable_if_t<DeserializeHelper<T>::isDeserializable>>
+inline T deserializeFrom(const char *src) {
+    if constexpr (HasDeserializeFrom<T>::value) {
+        return DeserializeHelper<T>::deserializeFrom(src);
+    } else {
+        MemoryStreamBuffer buffer(src, FixedDeserializedSizeRegister<T>::exactDeserializedSize);
+        std::istream is(&buffer);
+        return DeserializeHelper<T>::deserialize(is);
+    }
+}
+
 } // supermap::io
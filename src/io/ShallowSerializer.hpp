@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstring>
+
 #include "SerializeHelper.hpp"
 
 namespace supermap::io {
@@ -27,6 +29,15 @@ struct ShallowSerializer : Serializable<true> {
             );
         }
     }
+
+    /**
+     * @brief Copies all @p value memory to @p dst.
+     * @param value Object to serialize.
+     * @param dst Serialization destination, at least @p sizeof(T) bytes long.
+     */
+    static void serializeTo(const T &value, char *dst) {
+        std::memcpy(dst, &value, sizeof(T));
+    }
 };
 
 /**
@@ -47,6 +58,17 @@ struct ShallowDeserializer : Deserializable<true> {
         is.read(reinterpret_cast<char *>(&obj), sizeof(T));
         return obj;
     }
+
+    /**
+     * @brief Deserializes object from @p src shallowly, copying its memory.
+     * @param src Serialized object memory, at least @p sizeof(T) bytes long.
+     * @return Deserialized object.
+     */
+    static T deserializeFrom(const char *src) {
+        T obj;
+        std::memcpy(reinterpret_cast<char *>(&obj), src, sizeof(T));
+        return obj;
+    }
 };
 
 /**
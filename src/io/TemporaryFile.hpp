@@ -13,10 +13,13 @@ class TemporaryFile {
      * @brief Initializes TemporaryFile, which corresponds an actual file in FileManager.
      * @param path Name of file to create.
      * @param manager File system manager.
+     * @param create If @p false, file @p path must already exist, and it is taken as is.
      */
-    explicit TemporaryFile(const std::filesystem::path &path, std::shared_ptr<FileManager> manager)
+    explicit TemporaryFile(const std::filesystem::path &path, std::shared_ptr<FileManager> manager, bool create = true)
         : path_(path), manager_(std::move(manager)) {
-        manager_->create(path);
+        if (create) {
+            manager_->create(path);
+        }
     }
 
     TemporaryFile(TemporaryFile &&) = default;
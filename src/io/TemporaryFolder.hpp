@@ -33,9 +33,7 @@ class TemporaryFolder {
     TemporaryFolder &operator=(const TemporaryFolder &) = delete;
 
     TemporaryFolder &operator=(TemporaryFolder &&other) noexcept {
-        if (isFilesystem_) {
-            std::filesystem::remove(name_);
-        }
+        removeIfEmpty();
         isFilesystem_ = other.isFilesystem_;
         name_ = std::move(other.name_);
         return *this;
@@ -44,15 +42,22 @@ class TemporaryFolder {
     TemporaryFolder(TemporaryFolder &&other) noexcept = default;
 
     /**
-     * @brief Removes folder iff it was once actually created.
+     * @brief Removes folder iff it was once actually created and nothing is left in it.
+     * Persistent storage leaves its manifest, data files and write-ahead log, which keep the folder.
+     * The log is cleared on every checkpoint, so it holds only items added after the last one.
      */
     ~TemporaryFolder() {
+        removeIfEmpty();
+    }
+
+  private:
+    void removeIfEmpty() noexcept {
         if (isFilesystem_) {
-            std::filesystem::remove(name_);
+            std::error_code ignored;
+            std::filesystem::remove(name_, ignored);
         }
     }
 
-  private:
     bool isFilesystem_;
     std::string name_;
 };
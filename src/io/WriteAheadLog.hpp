@@ -0,0 +1,312 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "FileManager.hpp"
+#include "exception/IllegalArgumentException.hpp"
+
+namespace supermap::io {
+
+/**
+ * @brief Tells how often records of the @p WriteAheadLog are made durable.
+ */
+struct WalSyncPolicy {
+    enum class Mode {
+        /**
+         * @brief Log is never synchronized explicitly, records reach the disk when operating system decides so.
+         */
+        NEVER,
+
+        /**
+         * @brief Every @p period -th record waits until it and all previous records are synchronized.
+         */
+        EVERY_N_OPS,
+
+        /**
+         * @brief Log is synchronized in background every @p period milliseconds.
+         */
+        EVERY_T_MS,
+    };
+
+    Mode mode = Mode::NEVER;
+    std::uint64_t period = 0;
+
+    /**
+     * @return Policy which never synchronizes the log.
+     */
+    static WalSyncPolicy never() {
+        return WalSyncPolicy{Mode::NEVER, 0};
+    }
+
+    /**
+     * @param ops Number of records in one synchronized group. @p 1 makes every record durable.
+     * @return Policy which synchronizes the log every @p ops records.
+     */
+    static WalSyncPolicy everyOps(std::uint64_t ops) {
+        return WalSyncPolicy{Mode::EVERY_N_OPS, ops};
+    }
+
+    /**
+     * @param millis Synchronization period in milliseconds.
+     * @return Policy which synchronizes the log every @p millis milliseconds.
+     */
+    static WalSyncPolicy everyMillis(std::uint64_t millis) {
+        return WalSyncPolicy{Mode::EVERY_T_MS, millis};
+    }
+};
+
+/**
+ * @brief Append-only log of the objects of type @p T.
+ * Records are serialized to the in-memory buffer first. Buffered records are written to the log file
+ * with a single write, which is followed by a single data synchronization if @p WalSyncPolicy requires it,
+ * so records appended concurrently or one after another are committed as a group.
+ * Only one thread writes to the file at a time, others wait until their records are committed by it.
+ * All methods, except @p replay, are thread-safe.
+ * @tparam T Type of log record.
+ * @tparam EachSize Size of each @p T object in serialized format.
+ */
+template <
+    typename T,
+    std::size_t EachSize = FixedDeserializedSizeRegister<T>::exactDeserializedSize
+>
+class WriteAheadLog {
+  public:
+    /**
+     * @brief If this number of bytes is buffered, buffer is written to the file, even if
+     * synchronization is not required yet.
+     */
+    static constexpr std::size_t MAX_BUFFERED_BYTES = 64 * 1024;
+
+    /**
+     * @brief Number of records, which are read from the log with a single read during replay.
+     */
+    static constexpr std::uint64_t REPLAY_BATCH_SIZE = 4096;
+
+    /**
+     * @brief Opens log @p path, creating it if it does not exist.
+     * @param fileManager Log file manager.
+     * @param path Log file path.
+     * @param policy Synchronization policy.
+     * @throws IllegalArgumentException if @p policy period is zero, but should not be.
+     */
+    WriteAheadLog(std::shared_ptr<FileManager> fileManager,
+                  std::filesystem::path path,
+                  WalSyncPolicy policy)
+        : fileManager_(std::move(fileManager)),
+          path_(std::move(path)),
+          policy_(policy) {
+        if (policy_.mode != WalSyncPolicy::Mode::NEVER && policy_.period == 0) {
+            throw IllegalArgumentException("Write-ahead log synchronization period must be positive");
+        }
+        fileManager_->getOutputStream(path_, true)->flush();
+        if (policy_.mode == WalSyncPolicy::Mode::EVERY_T_MS) {
+            syncer_ = std::thread([this]() { syncInBackground(); });
+        }
+    }
+
+    WriteAheadLog(const WriteAheadLog &) = delete;
+    WriteAheadLog &operator=(const WriteAheadLog &) = delete;
+
+    /**
+     * @brief Reads all complete records of the log. Incomplete record at the end of the log,
+     * which could be left by the crash during write, is dropped from the file.
+     * Must be called before the first @p append.
+     * @tparam Consumer Type of function which accepts @p T&&.
+     * @param consumer Function which is applied to every record in order of appending.
+     * @return Number of read records.
+     */
+    template <typename Consumer>
+    std::uint64_t replay(Consumer consumer) {
+        std::uint64_t records;
+        {
+            auto input = fileManager_->getInputStream(path_, 0);
+            std::uint64_t bytes = input->availableBytes();
+            records = bytes / EachSize;
+            std::string data(std::min(records, REPLAY_BATCH_SIZE) * EachSize, '\0');
+            for (std::uint64_t read = 0; read < records;) {
+                std::uint64_t batch = std::min(records - read, REPLAY_BATCH_SIZE);
+                input->get().read(data.data(), static_cast<std::streamsize>(batch * EachSize));
+                for (std::uint64_t i = 0; i < batch; ++i) {
+                    consumer(deserializeFrom<T>(data.data() + i * EachSize));
+                }
+                read += batch;
+            }
+            if (bytes % EachSize == 0) {
+                return records;
+            }
+        }
+        const std::filesystem::path complete = path_.string() + "-complete";
+        {
+            auto input = fileManager_->getInputStream(path_, 0);
+            auto output = fileManager_->getOutputStream(complete, false);
+            std::string data(records * EachSize, '\0');
+            input->get().read(data.data(), static_cast<std::streamsize>(data.size()));
+            output->get().write(data.data(), static_cast<std::streamsize>(data.size()));
+            output->sync();
+        }
+        fileManager_->swap(path_, complete);
+        fileManager_->remove(complete);
+        return records;
+    }
+
+    /**
+     * @brief Appends @p record to the log. Depending on the policy, may wait
+     * until @p record and all records before it are synchronized.
+     * @param record Appended record.
+     * @throws FileException if the log can not be written or synchronized.
+     */
+    void append(const T &record) {
+        std::unique_lock lock(mutex_);
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+        buffer_.resize(buffer_.size() + EachSize);
+        serializeTo(record, buffer_.data() + buffer_.size() - EachSize);
+        const std::uint64_t seq = ++appended_;
+        if (policy_.mode == WalSyncPolicy::Mode::EVERY_N_OPS && seq - syncRequested_ >= policy_.period) {
+            syncRequested_ = seq;
+            commit(lock, seq, true);
+        } else if (buffer_.size() >= MAX_BUFFERED_BYTES) {
+            commit(lock, seq, false);
+        }
+    }
+
+    /**
+     * @brief Writes all appended records to the log file and synchronizes it.
+     * @throws FileException if the log can not be written or synchronized.
+     */
+    void sync() {
+        std::unique_lock lock(mutex_);
+        commit(lock, appended_, true);
+    }
+
+    /**
+     * @brief Drops all appended records. Must be called only when all of them are persisted elsewhere.
+     * @throws FileException if the log can not be truncated.
+     */
+    void clear() {
+        std::unique_lock lock(mutex_);
+        committed_.wait(lock, [this]() { return !committing_; });
+        buffer_.clear();
+        writer_.reset();
+        fileManager_->getOutputStream(path_, false)->sync();
+        written_ = synced_ = syncRequested_ = appended_;
+    }
+
+    /**
+     * @brief Stops background synchronization, writes all buffered records to the log file
+     * and synchronizes it unless policy is @p WalSyncPolicy::Mode::NEVER.
+     */
+    ~WriteAheadLog() {
+        if (syncer_.joinable()) {
+            {
+                std::lock_guard lock(mutex_);
+                stopping_ = true;
+            }
+            wakeUp_.notify_all();
+            syncer_.join();
+        }
+        try {
+            std::unique_lock lock(mutex_);
+            commit(lock, appended_, policy_.mode != WalSyncPolicy::Mode::NEVER);
+        } catch (...) {
+            // nothing can be done with the log anymore
+        }
+    }
+
+  private:
+    /**
+     * @brief Makes sure that first @p seq records are written, and synchronized if @p durable.
+     * If other thread is writing, waits until it finishes, since it may commit these records as well.
+     * @param lock Acquired lock of @p mutex_.
+     * @param seq Number of records to commit.
+     * @param durable If records must be synchronized.
+     */
+    void commit(std::unique_lock<std::mutex> &lock, std::uint64_t seq, bool durable) {
+        while (true) {
+            if ((durable ? synced_ : written_) >= seq) {
+                return;
+            }
+            if (!committing_) {
+                break;
+            }
+            committed_.wait(lock);
+        }
+        committing_ = true;
+        std::string group;
+        group.swap(buffer_);
+        const std::uint64_t groupEnd = appended_;
+        lock.unlock();
+        try {
+            if (!writer_) {
+                writer_ = fileManager_->getOutputStream(path_, true);
+            }
+            writer_->get().write(group.data(), static_cast<std::streamsize>(group.size()));
+            if (durable) {
+                writer_->sync();
+            } else {
+                writer_->flush();
+            }
+        } catch (...) {
+            lock.lock();
+            error_ = std::current_exception();
+            committing_ = false;
+            committed_.notify_all();
+            throw;
+        }
+        lock.lock();
+        written_ = groupEnd;
+        if (durable) {
+            synced_ = groupEnd;
+            lastSync_ = std::chrono::steady_clock::now();
+        }
+        committing_ = false;
+        committed_.notify_all();
+    }
+
+    /**
+     * @brief Background synchronization routine of @p WalSyncPolicy::Mode::EVERY_T_MS policy.
+     */
+    void syncInBackground() {
+        const std::chrono::milliseconds period(policy_.period);
+        std::unique_lock lock(mutex_);
+        while (true) {
+            wakeUp_.wait_until(lock, lastSync_ + period, [this]() { return stopping_; });
+            if (stopping_) {
+                return;
+            }
+            try {
+                commit(lock, appended_, true);
+            } catch (...) {
+                return;
+            }
+            lastSync_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    std::shared_ptr<FileManager> fileManager_;
+    const std::filesystem::path path_;
+    const WalSyncPolicy policy_;
+    std::unique_ptr<OutputStream> writer_;
+    std::string buffer_;
+    std::uint64_t appended_ = 0;
+    std::uint64_t written_ = 0;
+    std::uint64_t synced_ = 0;
+    std::uint64_t syncRequested_ = 0;
+    bool committing_ = false;
+    bool stopping_ = false;
+    std::exception_ptr error_;
+    std::chrono::steady_clock::time_point lastSync_ = std::chrono::steady_clock::now();
+    std::mutex mutex_;
+    std::condition_variable committed_;
+    std::condition_variable wakeUp_;
+    std::thread syncer_;
+};
+
+} // supermap::io
@@ -139,6 +139,15 @@ struct SerializeHelper<ByteArray<Len>> : Serializable<true> {
             throw IOException("Unsuccessful serialization, expected to write " + std::to_string(Len) + " bytes");
         }
     }
+
+    /**
+     * @brief Copies all memory from ByteArray @p ar to @p dst.
+     * @param ar Serialized array.
+     * @param dst Serialization destination, at least @p Len bytes long.
+     */
+    static void serializeTo(const ByteArray<Len> &ar, char *dst) {
+        std::memcpy(dst, ar.getCharsPointer(), Len);
+    }
 };
 
 /**
@@ -163,6 +172,17 @@ struct DeserializeHelper<ByteArray<Len>> : Deserializable<true> {
         }
         return ar;
     }
+
+    /**
+     * @brief Creates @p ByteArray from @p Len bytes of @p src.
+     * @param src Serialized array memory.
+     * @return Deserialized @p ByteArray.
+     */
+    static ByteArray<Len> deserializeFrom(const char *src) {
+        ByteArray<Len> ar;
+        std::memcpy(ar.getCharsPointer(), src, Len);
+        return ar;
+    }
 };
 
 /**
@@ -68,6 +68,16 @@ struct SerializeHelper<KeyValue<Key, Value>> : Serializable<true> {
         io::serialize(keyVal.key, os);
         io::serialize(keyVal.value, os);
     }
+
+    /**
+     * @brief Serializes @p keyVal to @p dst in the same format as @p serialize does.
+     * @param keyVal Serialized key-value pair.
+     * @param dst Serialization destination.
+     */
+    static void serializeTo(const KeyValue<Key, Value> &keyVal, char *dst) {
+        io::serializeTo(keyVal.key, dst);
+        io::serializeTo(keyVal.value, dst + FixedDeserializedSizeRegister<Key>::exactDeserializedSize);
+    }
 };
 
 /**
@@ -90,6 +100,19 @@ struct DeserializeHelper<KeyValue<Key, Value>> : Deserializable<true> {
                 io::deserialize<Value>(is)
             };
     }
+
+    /**
+     * @brief Deserializes @p KeyValue from memory @p src.
+     * @param src Serialized key-value pair memory.
+     * @return Deserialized key-value pair.
+     */
+    static KeyValue<Key, Value> deserializeFrom(const char *src) {
+        return KeyValue<Key, Value>
+            {
+                io::deserializeFrom<Key>(src),
+                io::deserializeFrom<Value>(src + FixedDeserializedSizeRegister<Key>::exactDeserializedSize)
+            };
+    }
 };
 
 /**
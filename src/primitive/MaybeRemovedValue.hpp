@@ -51,6 +51,11 @@ struct SerializeHelper<MaybeRemovedValue<T>> : Serializable<true> {
         io::serialize(val.value, os);
         io::serialize(val.removed, os);
     }
+
+    static void serializeTo(const MaybeRemovedValue<T> &val, char *dst) {
+        io::serializeTo(val.value, dst);
+        io::serializeTo(val.removed, dst + FixedDeserializedSizeRegister<T>::exactDeserializedSize);
+    }
 };
 
 /**
@@ -65,6 +70,13 @@ struct DeserializeHelper<MaybeRemovedValue<T>> : Deserializable<true> {
             io::deserialize<bool>(is)
         };
     }
+
+    static MaybeRemovedValue<T> deserializeFrom(const char *src) {
+        return {
+            io::deserializeFrom<T>(src),
+            io::deserializeFrom<bool>(src + FixedDeserializedSizeRegister<T>::exactDeserializedSize)
+        };
+    }
 };
 
 /**
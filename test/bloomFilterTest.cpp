@@ -1,11 +1,16 @@
 #include "doctest.h"
 
 #include "core/BloomFilter.hpp"
+#include "core/BlockedBloomFilter.hpp"
+#include "core/XorFilter.hpp"
+#include "core/FilteringRegister.hpp"
 #include "exception/IllegalArgumentException.hpp"
 #include "exception/IllegalStateException.hpp"
 #include "primitive/Key.hpp"
 
+#include <chrono>
 #include <random>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -115,4 +120,301 @@ TEST_CASE("Wrong state") {
         filter.reserve(0);
         filter.mightContain(key),
         supermap::IllegalStateException);
-}
\ No newline at end of file
+}
+TEST_CASE("Save and restore") {
+    constexpr std::uint32_t steps = 1000;
+    constexpr std::uint32_t length = 10;
+    supermap::BloomFilter<supermap::Key<length>> filter = getFilterWithErrorProbability<length>(1 / 32.0);
+    filter.reserve(steps);
+    std::vector<supermap::Key<length>> keys;
+    for (std::uint32_t k = 0; k < steps; ++k) {
+        keys.push_back(supermap::Key<length>::fromString(generateStringWithLength(length)));
+        filter.add(keys.back());
+    }
+    std::stringstream saved;
+    filter.save(saved);
+
+    supermap::BloomFilter<supermap::Key<length>> restored = getFilterWithErrorProbability<length>(1 / 32.0);
+    restored.restore(saved);
+    for (const auto &key : keys) {
+        CHECK(restored.mightContain(key));
+    }
+    for (std::uint32_t k = 0; k < steps; ++k) {
+        auto key = supermap::Key<length>::fromString(generateStringWithLength(length));
+        CHECK_EQ(restored.mightContain(key), filter.mightContain(key));
+    }
+}
+
+template <std::size_t Len>
+supermap::BlockedBloomFilter<supermap::Key<Len>> getBlockedFilterWithErrorProbability(double errorProbability) {
+    return supermap::BlockedBloomFilter<supermap::Key<Len>>(errorProbability, std::make_unique<supermap::XXHasher>());
+}
+
+template <std::size_t Len>
+supermap::Key<Len> getPaddedKey(std::string str) {
+    str.resize(Len, '_');
+    return supermap::Key<Len>::fromString(str);
+}
+
+template <std::size_t Len>
+double measureBlockedFalsePositiveRate(double errorProbability) {
+    constexpr std::uint32_t steps = 20000;
+    auto filter = getBlockedFilterWithErrorProbability<Len>(errorProbability);
+    filter.reserve(steps);
+    for (std::uint32_t k = 0; k < steps; ++k) {
+        auto key = getPaddedKey<Len>("in" + std::to_string(k));
+        filter.add(key);
+        CHECK(filter.mightContain(key));
+    }
+    std::uint32_t falsePositives = 0;
+    for (std::uint32_t k = 0; k < steps; ++k) {
+        falsePositives += filter.mightContain(getPaddedKey<Len>("out" + std::to_string(k)));
+    }
+    return static_cast<double>(falsePositives) / steps;
+}
+
+TEST_CASE("Blocked false positive rate") {
+    for (double errorProbability : {1 / 4.0, 1 / 32.0, 1 / 256.0}) {
+        CHECK(measureBlockedFalsePositiveRate<16>(errorProbability) <= 2 * errorProbability);
+    }
+}
+
+TEST_CASE("Blocked small keys") {
+    constexpr std::uint32_t steps = 1000;
+    constexpr std::uint32_t length = 1;
+    auto filter = getBlockedFilterWithErrorProbability<length>(1 / 32.0);
+    filter.reserve(steps);
+    std::vector<supermap::Key<length>> keys;
+    for (std::uint32_t k = 0; k < steps; ++k) {
+        keys.push_back(supermap::Key<length>::fromString(generateStringWithLength(length)));
+        filter.add(keys.back());
+    }
+    for (const auto &key : keys) {
+        CHECK(filter.mightContain(key));
+    }
+}
+
+TEST_CASE("Blocked save and restore") {
+    constexpr std::uint32_t steps = 1000;
+    constexpr std::uint32_t length = 10;
+    auto filter = getBlockedFilterWithErrorProbability<length>(1 / 32.0);
+    filter.reserve(steps);
+    std::vector<supermap::Key<length>> keys;
+    for (std::uint32_t k = 0; k < steps; ++k) {
+        keys.push_back(supermap::Key<length>::fromString(generateStringWithLength(length)));
+        filter.add(keys.back());
+    }
+    std::stringstream saved;
+    filter.save(saved);
+
+    auto restored = getBlockedFilterWithErrorProbability<length>(1 / 2.0);
+    restored.restore(saved);
+    for (const auto &key : keys) {
+        CHECK(restored.mightContain(key));
+    }
+    for (std::uint32_t k = 0; k < steps; ++k) {
+        auto key = supermap::Key<length>::fromString(generateStringWithLength(length));
+        CHECK_EQ(restored.mightContain(key), filter.mightContain(key));
+    }
+}
+
+TEST_CASE("Blocked wrong state") {
+    constexpr std::uint32_t length = 10;
+    supermap::Key<length> key = supermap::Key<length>::fromString(generateStringWithLength(length));
+    auto filter = getBlockedFilterWithErrorProbability<length>(1 / 32.0);
+    CHECK_THROWS_AS(filter.add(key), supermap::IllegalStateException);
+    filter.reserve(0);
+    CHECK_THROWS_AS(filter.mightContain(key), supermap::IllegalStateException);
+    CHECK_THROWS_AS(filter.reserve(10), supermap::IllegalStateException);
+    CHECK_THROWS_AS(getBlockedFilterWithErrorProbability<length>(0), supermap::IllegalArgumentException);
+}
+
+TEST_CASE("Hash functions count") {
+    constexpr std::uint32_t length = 10;
+    auto filter = supermap::BloomFilter<supermap::Key<length>>::withBitsPerElement(
+        10,
+        std::make_unique<supermap::XXHasher>()
+    );
+    filter.reserve(1000);
+    CHECK_EQ(filter.getHashFunctionsCount(), 7);
+    CHECK_THROWS_AS(
+        supermap::BloomFilter<supermap::Key<length>>::withBitsPerElement(0.5, std::make_unique<supermap::XXHasher>()),
+        supermap::IllegalArgumentException);
+}
+
+template <typename FilterT, std::size_t Len>
+void fillFilter(FilterT &filter, std::uint32_t steps) {
+    filter.reserve(steps);
+    for (std::uint32_t k = 0; k < steps; ++k) {
+        filter.add(getPaddedKey<Len>("in" + std::to_string(k)));
+    }
+}
+
+template <std::size_t Len>
+std::vector<supermap::Key<Len>> getAbsentKeys(std::uint32_t steps) {
+    std::vector<supermap::Key<Len>> absent;
+    absent.reserve(steps);
+    for (std::uint32_t k = 0; k < steps; ++k) {
+        absent.push_back(getPaddedKey<Len>("out" + std::to_string(k)));
+    }
+    return absent;
+}
+
+template <typename FilterT, std::size_t Len>
+double getFalsePositiveRate(FilterT filter) {
+    constexpr std::uint32_t steps = 100000;
+    fillFilter<FilterT, Len>(filter, steps);
+    std::uint32_t falsePositives = 0;
+    for (const auto &key : getAbsentKeys<Len>(steps)) {
+        falsePositives += filter.mightContain(key);
+    }
+    return static_cast<double>(falsePositives) / steps;
+}
+
+template <typename FilterT, std::size_t Len>
+void benchmarkProbes(FilterT filter, const std::string &name) {
+    constexpr std::uint32_t steps = 1000000;
+    fillFilter<FilterT, Len>(filter, steps);
+    std::vector<supermap::Key<Len>> absent = getAbsentKeys<Len>(steps);
+    std::uint32_t falsePositives = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto &key : absent) {
+        falsePositives += filter.mightContain(key);
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    MESSAGE(name << ": false positive rate " << static_cast<double>(falsePositives) / steps << ", "
+                 << static_cast<double>(elapsed.count()) / steps << " ns per probe");
+}
+
+TEST_CASE("Bits per key false positive rate") {
+    constexpr std::size_t length = 16;
+    constexpr std::uint64_t seed = 42;
+    using Bloom = supermap::BloomFilter<supermap::Key<length>>;
+    using BlockedBloom = supermap::BlockedBloomFilter<supermap::Key<length>>;
+    for (double bitsPerKey : {6.0, 10.0, 14.0}) {
+        double expected = std::pow(0.6185, bitsPerKey);
+        double bloomRate = getFalsePositiveRate<Bloom, length>(
+            Bloom::withBitsPerElement(bitsPerKey, std::make_unique<supermap::XXHasher>(), seed)
+        );
+        double blockedBloomRate = getFalsePositiveRate<BlockedBloom, length>(
+            BlockedBloom::withBitsPerElement(bitsPerKey, std::make_unique<supermap::XXHasher>(), seed)
+        );
+        CHECK_LE(bloomRate, 1.5 * expected);
+        CHECK_LE(blockedBloomRate, 2 * expected);
+    }
+}
+
+// Measures probe cost, so it runs only when asked with --no-skip.
+TEST_CASE("Bits per key probe benchmark" * doctest::skip()) {
+    constexpr std::size_t length = 16;
+    using Bloom = supermap::BloomFilter<supermap::Key<length>>;
+    using BlockedBloom = supermap::BlockedBloomFilter<supermap::Key<length>>;
+    for (double bitsPerKey : {6.0, 10.0, 14.0}) {
+        benchmarkProbes<Bloom, length>(
+            Bloom::withBitsPerElement(bitsPerKey, std::make_unique<supermap::XXHasher>()),
+            "BloomFilter, " + std::to_string(bitsPerKey) + " bits per key"
+        );
+        benchmarkProbes<BlockedBloom, length>(
+            BlockedBloom::withBitsPerElement(bitsPerKey, std::make_unique<supermap::XXHasher>()),
+            "BlockedBloomFilter, " + std::to_string(bitsPerKey) + " bits per key"
+        );
+    }
+}
+
+TEST_CASE("Xor filter") {
+    constexpr std::size_t length = 16;
+    constexpr std::uint32_t steps = 50000;
+    supermap::XorFilter<supermap::Key<length>> filter(std::make_unique<supermap::XXHasher>(), 42);
+    filter.reserve(steps);
+    for (std::uint32_t k = 0; k < steps; ++k) {
+        filter.add(getPaddedKey<length>("in" + std::to_string(k)));
+        filter.add(getPaddedKey<length>("in" + std::to_string(k / 2)));
+    }
+    CHECK(filter.mightContain(getPaddedKey<length>("out")));
+    filter.seal();
+    CHECK_THROWS_AS(filter.add(getPaddedKey<length>("in")), supermap::IllegalStateException);
+    for (std::uint32_t k = 0; k < steps; ++k) {
+        CHECK(filter.mightContain(getPaddedKey<length>("in" + std::to_string(k))));
+    }
+    std::uint32_t falsePositives = 0;
+    for (std::uint32_t k = 0; k < steps; ++k) {
+        falsePositives += filter.mightContain(getPaddedKey<length>("out" + std::to_string(k)));
+    }
+    double rate = static_cast<double>(falsePositives) / steps;
+    double bitsPerKey = static_cast<double>(filter.getMemoryBits()) / steps;
+    CHECK_LE(rate, 2 / 256.0);
+    CHECK_LE(bitsPerKey, 10.0);
+
+    std::stringstream saved;
+    filter.save(saved);
+    supermap::XorFilter<supermap::Key<length>> restored(std::make_unique<supermap::XXHasher>());
+    restored.restore(saved);
+    for (std::uint32_t k = 0; k < steps; ++k) {
+        auto key = getPaddedKey<length>("in" + std::to_string(k));
+        CHECK(restored.mightContain(key));
+    }
+}
+
+TEST_CASE("Empty xor filter") {
+    constexpr std::size_t length = 4;
+    supermap::XorFilter<supermap::Key<length>> filter(std::make_unique<supermap::XXHasher>());
+    filter.seal();
+    std::uint32_t falsePositives = 0;
+    for (std::uint32_t k = 0; k < 1000; ++k) {
+        falsePositives += filter.mightContain(getPaddedKey<length>(std::to_string(k)));
+    }
+    CHECK_LE(falsePositives, 20);
+}
+
+TEST_CASE("Filtering register shares sealed filter") {
+    using K = supermap::Key<2>;
+    using Register = supermap::FilteringRegister<K, K>;
+
+    Register filteringRegister(
+        []() { return std::make_shared<supermap::BloomFilter<K>>(getFilterWithErrorProbability<2>(0.01)); },
+        [](const K &key) { return key; }
+    );
+    filteringRegister.reserve(10);
+    filteringRegister.registerItem(K::fromString("ab"));
+
+    auto building = filteringRegister.clone();
+    CHECK_EQ(building->getRegisteredItemsInfo(), filteringRegister.getRegisteredItemsInfo());
+    building->registerItem(K::fromString("cd"));
+    CHECK(building->getRegisteredItemsInfo() != filteringRegister.getRegisteredItemsInfo());
+    CHECK(building->getRegisteredItemsInfo()->mightContain(K::fromString("cd")));
+
+    filteringRegister.seal();
+    CHECK(filteringRegister.isSealed());
+    auto sealed = filteringRegister.clone();
+    CHECK_EQ(sealed->getRegisteredItemsInfo(), filteringRegister.getRegisteredItemsInfo());
+    sealed->seal();
+    CHECK_EQ(sealed->getRegisteredItemsInfo(), filteringRegister.getRegisteredItemsInfo());
+}
+
+TEST_CASE("Hashed filter check") {
+    using K = supermap::Key<4>;
+
+    supermap::XXHasher hasher;
+    K key = K::fromString("abcd");
+    std::stringstream serialized;
+    supermap::io::serialize(key, serialized);
+    CHECK_EQ(supermap::hashTools::hashWith(hasher, key, 1), hasher.hash(serialized.str(), 1));
+
+    std::vector<std::unique_ptr<supermap::Filter<K>>> filters;
+    filters.push_back(std::make_unique<supermap::BloomFilter<K>>(getFilterWithErrorProbability<4>(0.01)));
+    filters.push_back(std::make_unique<supermap::BlockedBloomFilter<K>>(
+        0.01, std::make_unique<supermap::XXHasher>()));
+    filters.push_back(std::make_unique<supermap::XorFilter<K>>(std::make_unique<supermap::XXHasher>()));
+    for (auto &filter : filters) {
+        filter->reserve(100);
+        for (std::size_t i = 0; i < 100; ++i) {
+            filter->add(K::fromString(std::to_string(1000 + i)));
+        }
+        filter->seal();
+        for (std::size_t i = 0; i < 1000; ++i) {
+            K checked = K::fromString(std::to_string(1000 + i));
+            CHECK_EQ(filter->mightContainHashed(checked, supermap::hashTools::hashKey(hasher, checked)),
+                     filter->mightContain(checked));
+        }
+    }
+}
@@ -1,9 +1,14 @@
 #include "doctest.h"
 
+#include <array>
+#include <atomic>
 #include <filesystem>
 #include <vector>
 #include <chrono>
 #include <functional>
+#include <map>
+#include <random>
+#include <thread>
 
 #include "io/InputStream.hpp"
 #include "io/InputIterator.hpp"
@@ -12,6 +17,9 @@
 #include "io/OutputIterator.hpp"
 #include "io/RamFileManager.hpp"
 #include "io/DiskFileManager.hpp"
+#include "io/MmapFileManager.hpp"
+#include "io/WriteAheadLog.hpp"
+#include "io/MemoryStreamBuffer.hpp"
 
 #include "exception/IllegalArgumentException.hpp"
 
@@ -21,7 +29,10 @@
 #include "core/KeyValueShrinkableStorage.hpp"
 #include "core/BinaryCollapsingSortedStoragesList.hpp"
 #include "core/BST.hpp"
+#include "core/SkipList.hpp"
+#include "core/HashTable.hpp"
 #include "core/MockFilter.hpp"
+#include "core/MpscQueue.hpp"
 #include "hasher/XXHasher.hpp"
 #include "builder/ShardedSupermapBuilder.hpp"
 #include "builder/DefaultSupermap.hpp"
@@ -35,6 +46,17 @@ bool operator==(const KeyValue<Key, Value> &a, const KeyValue<Key, Value> &b) {
 }
 }
 
+// Keys are distinct for i < 676, values for i < 900.
+supermap::Key<2> makeKey2(std::size_t i) {
+    return supermap::Key<2>::fromString(std::string{
+        static_cast<char>('a' + i / 26), static_cast<char>('a' + i % 26)
+    });
+}
+
+supermap::ByteArray<3> makeValue(std::size_t i) {
+    return supermap::ByteArray<3>::fromString(std::to_string(100 + i % 900));
+}
+
 struct TempFile {
     const std::string filename = ".supermap-test-file";
 
@@ -190,6 +212,160 @@ TEST_CASE ("RamFileManager") {
     CHECK_THROWS_AS(manager.getInputStream(paths[0], 0), const supermap::FileException &);
 }
 
+TEST_CASE ("DiskFileManager cached descriptors") {
+    supermap::io::DiskFileManager manager(1);
+    TempFile first("first");
+    const std::string secondName = ".supermap-test-file-second";
+    {
+        std::ofstream second(secondName);
+        second << "second";
+    }
+    std::string data;
+    manager.getInputStream(first.filename, 0)->get() >> data;
+    CHECK_EQ(data, "first");
+    manager.getInputStream(secondName, 0)->get() >> data;
+    CHECK_EQ(data, "second");
+    manager.swap(first.filename, secondName);
+    manager.getInputStream(first.filename, 0)->get() >> data;
+    CHECK_EQ(data, "second");
+    auto stream = manager.getInputStream(secondName, 3);
+    CHECK_EQ(stream->availableBytes(), 2);
+    stream->get() >> data;
+    CHECK_EQ(data, "st");
+    CHECK_EQ(stream->availableBytes(), 0);
+    manager.remove(secondName);
+    CHECK_THROWS_AS(manager.getInputStream(secondName, 0), const supermap::FileException &);
+}
+
+TEST_CASE ("FileManager readAt") {
+    auto check = [](supermap::io::FileManager &manager, const std::filesystem::path &path) {
+        std::array<char, 4> buffer{};
+        manager.readAt(path, 2, 4, buffer.data());
+        CHECK_EQ(std::string(buffer.data(), 4), "2345");
+        manager.readAt(path, 6, 4, buffer.data());
+        CHECK_EQ(std::string(buffer.data(), 4), "6789");
+        CHECK_THROWS_AS(manager.readAt(path, 7, 4, buffer.data()), const supermap::IOException &);
+        CHECK_THROWS_AS(manager.readAt(path, UINT64_MAX - 1, 4, buffer.data()), const supermap::IOException &);
+    };
+    supermap::io::RamFileManager ramManager;
+    {
+        auto output = ramManager.getOutputStream("data", false);
+        output->get() << "0123456789";
+        output->flush();
+    }
+    check(ramManager, "data");
+    supermap::io::DiskFileManager diskManager;
+    TempFile file("0123456789");
+    check(diskManager, file.filename);
+    supermap::io::MmapFileManager mmapManager;
+    check(mmapManager, file.filename);
+}
+
+TEST_CASE ("DiskFileManager block cache") {
+    using supermap::io::BlockCache;
+    auto cache = std::make_shared<BlockCache>(BlockCache::BLOCK_SIZE * BlockCache::SHARDS_NUMBER);
+    supermap::io::DiskFileManager manager(supermap::io::DiskFileManager::DEFAULT_MAX_OPEN_FILES, cache);
+    std::string contents(BlockCache::BLOCK_SIZE * 2 + 10, 'a');
+    for (std::size_t i = 0; i < contents.size(); ++i) {
+        contents[i] = static_cast<char>('a' + i % 26);
+    }
+    TempFile file(contents);
+    std::vector<char> buffer(BlockCache::BLOCK_SIZE + 20);
+    manager.readAt(file.filename, BlockCache::BLOCK_SIZE - 10, buffer.size(), buffer.data());
+    CHECK_EQ(std::string(buffer.begin(), buffer.end()), contents.substr(BlockCache::BLOCK_SIZE - 10, buffer.size()));
+    CHECK_EQ(cache->getHits(), 0);
+    manager.readAt(file.filename, BlockCache::BLOCK_SIZE - 10, buffer.size(), buffer.data());
+    CHECK_EQ(std::string(buffer.begin(), buffer.end()), contents.substr(BlockCache::BLOCK_SIZE - 10, buffer.size()));
+    CHECK_EQ(cache->getHits(), 2);
+    manager.readAt(file.filename, contents.size() - 5, 5, buffer.data());
+    CHECK_EQ(std::string(buffer.data(), 5), contents.substr(contents.size() - 5));
+    CHECK_THROWS_AS(manager.readAt(file.filename, contents.size() - 5, 6, buffer.data()), const supermap::IOException &);
+    {
+        auto output = manager.getOutputStream(file.filename, false);
+        output->get() << std::string(BlockCache::BLOCK_SIZE, 'z');
+        output->flush();
+    }
+    manager.readAt(file.filename, 0, 3, buffer.data());
+    CHECK_EQ(std::string(buffer.data(), 3), "zzz");
+
+    supermap::io::MmapFileManager mmapManager(supermap::io::DiskFileManager::DEFAULT_MAX_OPEN_FILES, cache);
+    const std::size_t hits = cache->getHits();
+    mmapManager.readAt(file.filename, 1, 3, buffer.data());
+    CHECK_EQ(std::string(buffer.data(), 3), "zzz");
+    CHECK_EQ(cache->getHits(), hits + 1);
+}
+
+TEST_CASE ("BlockCache invalidates blocks of one file") {
+    using supermap::io::BlockCache;
+    using supermap::io::FileId;
+    BlockCache cache(BlockCache::BLOCK_SIZE * BlockCache::SHARDS_NUMBER * 4);
+    BlockCache::Block block{};
+    const FileId first{1, 1};
+    const FileId second{1, 2};
+    for (std::uint64_t i = 0; i < 3; ++i) {
+        block.fill(static_cast<char>('a' + i));
+        cache.insert(first, i, block, cache.getEpoch(first));
+        cache.insert(second, i, block, cache.getEpoch(second));
+    }
+    const std::uint64_t staleEpoch = cache.getEpoch(first);
+    cache.invalidate(first);
+    char c = 0;
+    for (std::uint64_t i = 0; i < 3; ++i) {
+        CHECK(!cache.read(first, i, 0, 1, &c));
+        CHECK(cache.read(second, i, 0, 1, &c));
+        CHECK_EQ(c, static_cast<char>('a' + i));
+    }
+    cache.insert(first, 0, block, staleEpoch);
+    CHECK(!cache.read(first, 0, 0, 1, &c));
+    cache.insert(first, 0, block, cache.getEpoch(first));
+    CHECK(cache.read(first, 0, 0, 1, &c));
+}
+
+TEST_CASE ("MmapFileManager maps sealed files") {
+    supermap::io::MmapFileManager manager;
+    TempFile file("abc");
+    const std::string otherName = ".supermap-test-file-other";
+    std::array<char, 3> buffer{};
+    manager.readAt(file.filename, 0, 3, buffer.data());
+    CHECK_EQ(std::string(buffer.data(), 3), "abc");
+    manager.seal(file.filename);
+    {
+        auto output = manager.getOutputStream(file.filename, true);
+        output->get() << "def";
+        output->flush();
+    }
+    manager.readAt(file.filename, 3, 3, buffer.data());
+    CHECK_EQ(std::string(buffer.data(), 3), "def");
+    manager.seal(file.filename);
+    manager.readAt(file.filename, 1, 3, buffer.data());
+    CHECK_EQ(std::string(buffer.data(), 3), "bcd");
+    CHECK_THROWS_AS(manager.readAt(file.filename, UINT64_MAX - 1, 3, buffer.data()), const supermap::IOException &);
+    {
+        auto output = manager.getOutputStream(otherName, false);
+        output->get() << "xy";
+        output->flush();
+    }
+    manager.seal(otherName);
+    manager.swap(file.filename, otherName);
+    manager.readAt(file.filename, 0, 2, buffer.data());
+    CHECK_EQ(std::string(buffer.data(), 2), "xy");
+    manager.readAt(otherName, 3, 3, buffer.data());
+    CHECK_EQ(std::string(buffer.data(), 3), "def");
+    auto stream = manager.getInputStream(file.filename, 0);
+    CHECK_EQ(stream->availableBytes(), 2);
+    std::string data;
+    stream->get() >> data;
+    CHECK_EQ(data, "xy");
+    CHECK_THROWS_AS(manager.readAt(file.filename, 0, 3, buffer.data()), const supermap::IOException &);
+    {
+        auto output = manager.getOutputStream(otherName, false);
+    }
+    CHECK_EQ(manager.getInputStream(otherName, 0)->availableBytes(), 0);
+    CHECK_THROWS_AS(manager.readAt(otherName, 0, 1, buffer.data()), const supermap::IOException &);
+    manager.remove(otherName);
+    CHECK_THROWS_AS(manager.getInputStream(otherName, 0), const supermap::FileException &);
+}
+
 TEST_CASE ("Key") {
     auto key6 = supermap::Key<6>::fromString("123456");
     CHECK_EQ(key6.toString(), "123456");
@@ -234,6 +410,47 @@ TEST_CASE ("SingleFileIndexedStorage KeyIndex") {
     CHECK_EQ(keys, parsedData);
 }
 
+TEST_CASE ("SingleFileIndexedStorage append buffer") {
+    using namespace supermap;
+
+    std::shared_ptr<io::FileManager> manager = std::make_shared<io::DiskFileManager>();
+    SingleFileIndexedStorage<int, int, void> storage(
+        "buffered",
+        manager,
+        []() { return std::make_unique<VoidRegister<int>>(); },
+        3 * sizeof(int)
+    );
+    for (int i = 0; i < 10; ++i) {
+        storage.appendCopy(i);
+        CHECK_EQ(storage.getItemsCount(), i + 1);
+        for (int j = 0; j <= i; ++j) {
+            CHECK_EQ(storage.get(j), j);
+        }
+    }
+    CHECK_EQ(manager->getInputStream("buffered", 0)->availableBytes(), 8 * sizeof(int));
+    CHECK(!storage.isFlushed());
+    storage.flush();
+    CHECK(storage.isFlushed());
+    CHECK_EQ(manager->getInputStream("buffered", 0)->availableBytes(), 10 * sizeof(int));
+    SingleFileIndexedStorage<int, int, void> copy = storage;
+    storage.appendCopy(10);
+    CHECK_EQ(manager->getInputStream("buffered", 0)->availableBytes(), 10 * sizeof(int));
+    storage.flush();
+    CHECK_EQ(storage.getDataIterator().collect(), std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+
+    SingleFileIndexedStorage<int, int, void> other(
+        "other",
+        manager,
+        []() { return std::make_unique<VoidRegister<int>>(); },
+        3 * sizeof(int)
+    );
+    other.appendCopy(42);
+    storage.resetWith(std::move(other));
+    storage.appendCopy(43);
+    storage.flush();
+    CHECK_EQ(storage.getDataIterator().collect(), std::vector<int>{42, 43});
+}
+
 TEST_CASE ("KeyValueShrinkableStorage notSortedStorage") {
     using namespace supermap;
     using namespace io;
@@ -350,6 +567,50 @@ TEST_CASE("Enum serialization") {
     CHECK_EQ(io::deserialize<KeyIndex>(in.get()), KeyIndex{'b', 2});
 }
 
+TEST_CASE("Span serialization") {
+    using namespace supermap;
+
+    using KV = KeyValue<Key<2>, ByteArray<4>>;
+
+    KV kv{Key<2>::fromString("ab"), ByteArray<4>::fromString("1234")};
+    std::string streamed;
+    io::StringOutputStream out(streamed, false);
+    io::serialize(kv, out.get());
+    out.flush();
+    std::array<char, io::FixedDeserializedSizeRegister<KV>::exactDeserializedSize> memory{};
+    io::serializeTo(kv, memory.data());
+    CHECK_EQ(std::string(memory.begin(), memory.end()), streamed);
+    CHECK(io::deserializeFrom<KV>(memory.data()).equals(kv));
+
+    std::string buffer;
+    auto outIt = io::OutputIterator<KeyValue<char, std::uint32_t>>::toString(buffer, false);
+    std::vector<KeyValue<char, std::uint32_t>> written{{'a', 1}, {'b', 2}, {'c', 3}};
+    outIt.writeAll(written.begin(), written.end(), [](const auto &x) { return x; });
+    outIt.flush();
+    auto inIt = io::InputIterator<KeyValue<char, std::uint32_t>, std::uint32_t>::fromString(buffer);
+    CHECK_EQ(inIt.collect(), written);
+}
+
+TEST_CASE("MemoryStreamBuffer") {
+    std::array<char, 6> memory{};
+    supermap::io::MemoryStreamBuffer buffer(memory.data(), memory.size());
+    std::ostream os(&buffer);
+    os << "abcdef";
+    CHECK(!(os << 'g'));
+    os.clear();
+    os.seekp(2);
+    os << "XY";
+    CHECK_EQ(std::string(memory.begin(), memory.end()), "abXYef");
+    std::istream is(&buffer);
+    is.seekg(-3, std::ios_base::end);
+    std::string rest;
+    is >> rest;
+    CHECK_EQ(rest, "Yef");
+    supermap::io::MemoryStreamBuffer readOnly(static_cast<const char *>(memory.data()), memory.size());
+    std::ostream readOnlyOs(&readOnly);
+    CHECK(!(readOnlyOs << 'z'));
+}
+
 TEST_CASE("Enum collect ram") {
     using namespace supermap;
 
@@ -554,6 +815,58 @@ TEST_CASE("KeyValueShrinkableStorage shrink advanced") {
     }
 }
 
+TEST_CASE("KeyValueShrinkableStorage shrink next generation") {
+    using namespace supermap;
+
+    using Storage = KeyValueShrinkableStorage<Key<1>, ByteArray<1>, std::uint32_t, void>;
+
+    std::shared_ptr<io::FileManager> manager = std::make_shared<io::DiskFileManager>();
+    auto storage = std::make_shared<Storage>(
+        "generation-not-sorted",
+        "generation-sorted",
+        manager,
+        []() { return std::make_unique<VoidRegister<KeyValue<Key<1>, std::uint32_t>>>(); }
+    );
+
+    auto keyVal = [&](const std::string &k, const std::string &v) {
+        return KeyValue<Key<1>, ByteArray<1>>{Key<1>::fromString(k), ByteArray<1>::fromString(v)};
+    };
+
+    storage->appendCopy(keyVal("2", "a"));
+    storage->appendCopy(keyVal("5", "b"));
+    storage->appendCopy(keyVal("2", "c"));
+
+    std::shared_ptr<const Storage> frozen = std::move(storage);
+    Storage next = frozen->createNextGeneration("generation-next-not-sorted", "generation-next-sorted");
+    CHECK_EQ(next.getNotSortedBase(), 3);
+    next.appendCopy(keyVal("5", "x"));
+    next.appendCopy(keyVal("7", "y"));
+
+    auto checkFrozen = [&]() {
+        CHECK_EQ(frozen->get(0), keyVal("2", "a"));
+        CHECK_EQ(frozen->get(1), keyVal("5", "b"));
+        CHECK_EQ(frozen->get(2), keyVal("2", "c"));
+        CHECK_EQ(next.get(3), keyVal("5", "x"));
+        CHECK_EQ(next.get(4), keyVal("7", "y"));
+    };
+    checkFrozen();
+
+    auto [shrunk, actualIndex] = frozen->shrinkToNew(1, "generation-shrink", "generation-new-index");
+    checkFrozen();
+    CHECK_EQ(shrunk.getNotSortedItemsCount(), 0);
+    CHECK_EQ(actualIndex.getItemsCount(), 2);
+    CHECK_EQ(actualIndex.get(0), KeyValue<Key<1>, std::uint32_t>(Key<1>::fromString("2"), 0));
+    CHECK_EQ(actualIndex.get(1), KeyValue<Key<1>, std::uint32_t>(Key<1>::fromString("5"), 1));
+
+    next.resetSortedWith(std::move(shrunk));
+    CHECK_EQ(next.getSortedItemsCount(), 2);
+    CHECK_EQ(next.getItemsCount(), 5);
+    CHECK_EQ(next.get(0), keyVal("2", "c"));
+    CHECK_EQ(next.get(1), keyVal("5", "b"));
+    CHECK_EQ(next.get(3), keyVal("5", "x"));
+    CHECK_EQ(next.get(4), keyVal("7", "y"));
+}
+
 TEST_CASE ("SortEndIterator 1") {
     using namespace supermap;
 
@@ -658,6 +971,43 @@ TEST_CASE("SortedSingleFileIndexedStorage find int") {
     CHECK_EQ(findElem(3), std::optional{3});
 }
 
+TEST_CASE("SortedSingleFileIndexedStorage find by fences") {
+    using namespace supermap;
+    using Storage = SortedSingleFileIndexedStorage<int, int, void, int>;
+
+    std::shared_ptr<io::FileManager> manager = std::make_shared<io::RamFileManager>();
+    const int itemsCount = static_cast<int>(Storage::FENCE_STEP) * 3 + 5;
+    std::vector<int> items;
+    for (int i = 0; i < itemsCount; ++i) {
+        items.push_back(i * 2);
+    }
+    Storage storage(
+        items.begin(),
+        items.begin() + itemsCount / 2,
+        true,
+        "sorted-keys",
+        manager,
+        [](int a, int b) { return a < b; },
+        [](int a, int b) { return a == b; },
+        []() { return std::make_unique<VoidRegister<int>>(); }
+    );
+    storage.appendAll(items.begin() + itemsCount / 2, items.end());
+    auto findElem = [&](int elem) {
+        return storage.find(
+            elem,
+            [](const int &storageElem, const int &myElem) { return storageElem < myElem; },
+            [](const int &storageElem, const int &myElem) { return storageElem == myElem; }
+        );
+    };
+
+    CHECK_EQ(findElem(-1), std::nullopt);
+    CHECK_EQ(findElem(itemsCount * 2), std::nullopt);
+    for (int i = 0; i < itemsCount; ++i) {
+        CHECK_EQ(findElem(i * 2), std::optional{i * 2});
+        CHECK_EQ(findElem(i * 2 + 1), std::nullopt);
+    }
+}
+
 TEST_CASE("SortedSingleFileIndexedStorage find CharKV") {
     using namespace supermap;
 
@@ -700,6 +1050,43 @@ TEST_CASE("SortedSingleFileIndexedStorage find CharKV") {
     CHECK_EQ(findElem(3), std::optional{CharKV{3, 7}});
 }
 
+TEST_CASE("SortedSingleFileIndexedStorage merge") {
+    using namespace supermap;
+    using Storage = SortedSingleFileIndexedStorage<CharKV, int, void, char>;
+
+    std::shared_ptr<io::FileManager> manager = std::make_shared<io::RamFileManager>();
+    std::vector<std::vector<CharKV>> blocks = {
+        {{1, 0}, {3, 0}, {5, 0}, {7, 0}, {9, 0}},
+        {{2, 1}, {3, 1}, {4, 1}},
+        {},
+        {{0, 3}, {3, 3}, {9, 3}, {10, 3}},
+    };
+    std::vector<Storage> newer;
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+        newer.emplace_back(
+            blocks[i].begin(),
+            blocks[i].end(),
+            true,
+            "block-" + std::to_string(i),
+            manager,
+            [](const CharKV &a, const CharKV &b) { return a.key < b.key; },
+            [](const CharKV &a, const CharKV &b) { return a.key == b.key; },
+            []() { return std::make_unique<VoidRegister<CharKV>>(); }
+        );
+    }
+    Storage merged(newer, "merged", manager, 2, []() { return std::make_unique<VoidRegister<CharKV>>(); });
+
+    std::vector<CharKV> expected = {
+        {0, 3}, {1, 0}, {2, 1}, {3, 3}, {4, 1}, {5, 0}, {7, 0}, {9, 3}, {10, 3},
+    };
+    CHECK_EQ(merged.getItemsCount(), expected.size());
+    std::vector<CharKV> actual = merged.getDataIterator().collect();
+    CHECK_EQ(actual.size(), expected.size());
+    for (std::size_t i = 0; i < std::min(actual.size(), expected.size()); ++i) {
+        CHECK(actual[i].equals(expected[i]));
+    }
+}
+
 TEST_CASE("BinaryCollapsingSortedStoragesList") {
     using namespace supermap;
 
@@ -761,6 +1148,197 @@ TEST_CASE("BinaryCollapsingSortedStoragesList") {
     CHECK_EQ(find(5), std::nullopt);
 }
 
+TEST_CASE("BinaryCollapsingSortedStoragesList background compaction") {
+    using namespace supermap;
+    using Storage = SortedSingleFileIndexedStorage<CharKV, int, void, char>;
+
+    std::shared_ptr<io::FileManager> manager = std::make_shared<io::DiskFileManager>();
+    BinaryCollapsingSortedStoragesList<CharKV, int, void, char> list(
+        2,
+        []() { return std::make_unique<VoidRegister<CharKV>>(); },
+        true
+    );
+    auto find = [&](char x) {
+        return list.find(
+            x,
+            [](const CharKV &a, const char &t) { return a.key < t; },
+            [](const CharKV &a, const char &t) { return t == a.key; }
+        );
+    };
+
+    const int blocksCount = 100;
+    for (int block = 0; block < blocksCount; ++block) {
+        std::vector<CharKV> items = {
+            {static_cast<char>(block % 10), static_cast<char>(block)},
+            {static_cast<char>(10 + block % 7), static_cast<char>(block)},
+        };
+        list.append(std::make_unique<Storage>(
+            items.begin(),
+            items.end(),
+            true,
+            "block-" + std::to_string(block),
+            manager,
+            [](const CharKV &a, const CharKV &b) { return a.key < b.key; },
+            [](const CharKV &a, const CharKV &b) { return a.key == b.key; },
+            []() { return std::make_unique<VoidRegister<CharKV>>(); }
+        ));
+        CHECK_EQ(find(static_cast<char>(block % 10))->value, static_cast<char>(block));
+        CHECK_EQ(find(static_cast<char>(10 + block % 7))->value, static_cast<char>(block));
+    }
+    for (char key = 0; key < 10; ++key) {
+        CHECK_EQ(find(key)->value, static_cast<char>(blocksCount - 10 + key));
+    }
+    CHECK_EQ(find(17), std::nullopt);
+}
+
+TEST_CASE ("SkipList") {
+    using namespace supermap;
+
+    SkipList<int, std::string, std::size_t> skipList;
+    std::map<int, std::string> expected;
+    std::mt19937 rnd(239);
+    for (std::size_t i = 0; i < 5000; ++i) {
+        int key = static_cast<int>(rnd() % 1000);
+        if (rnd() % 5 == 0) {
+            skipList.remove(key);
+            expected.erase(key);
+        } else {
+            skipList.add(key, std::to_string(i));
+            expected[key] = std::to_string(i);
+        }
+    }
+    CHECK_EQ(skipList.getUpperSizeBound(), expected.size());
+    for (int key = 0; key < 1000; ++key) {
+        auto it = expected.find(key);
+        CHECK_EQ(skipList.getValue(key), it == expected.end() ? std::nullopt : std::optional{it->second});
+    }
+    auto extracted = std::move(skipList).extract();
+    CHECK_EQ(extracted.size(), expected.size());
+    CHECK(std::equal(extracted.begin(), extracted.end(), expected.begin(), [](const auto &kv, const auto &p) {
+        return kv.key == p.first && kv.value == p.second;
+    }));
+    CHECK_EQ(skipList.getUpperSizeBound(), 0);
+    CHECK_EQ(skipList.getValue(0), std::nullopt);
+    skipList.add(1, "1");
+    CHECK_EQ(skipList.getValue(1), std::optional<std::string>{"1"});
+}
+
+TEST_CASE ("SkipList destroys replaced and removed values") {
+    using namespace supermap;
+
+    auto tracked = std::make_shared<int>(0);
+    {
+        SkipList<int, std::shared_ptr<int>, std::size_t> skipList;
+        skipList.add(1, std::shared_ptr<int>(tracked));
+        skipList.add(1, std::shared_ptr<int>(tracked));
+        skipList.add(2, std::shared_ptr<int>(tracked));
+        skipList.remove(2);
+        CHECK_EQ(tracked.use_count(), 4);
+    }
+    CHECK_EQ(tracked.use_count(), 1);
+}
+
+TEST_CASE ("SkipList concurrent readers") {
+    using namespace supermap;
+
+    constexpr std::size_t KEYS = 20000;
+    SkipList<std::size_t, std::size_t, std::size_t> skipList;
+    std::atomic<bool> stop = false;
+    std::atomic<std::size_t> wrongValues = 0;
+    std::vector<std::thread> readers;
+    for (std::size_t r = 0; r < 3; ++r) {
+        readers.emplace_back([&, r]() {
+            std::mt19937 rnd(r);
+            while (!stop.load()) {
+                std::size_t key = rnd() % KEYS;
+                std::optional<std::size_t> value = skipList.getValue(key);
+                if (value.has_value() && value.value() != key * 2 && value.value() != key * 2 + 1) {
+                    ++wrongValues;
+                }
+            }
+        });
+    }
+    for (std::size_t i = 0; i < KEYS; ++i) {
+        skipList.add((i * 7919) % KEYS, (i * 7919) % KEYS * 2);
+    }
+    for (std::size_t key = 0; key < KEYS; key += 2) {
+        skipList.add(key, key * 2 + 1);
+    }
+    stop = true;
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    CHECK_EQ(wrongValues.load(), 0);
+    CHECK_EQ(skipList.getUpperSizeBound(), KEYS);
+    std::size_t previous = 0;
+    std::size_t count = 0;
+    std::move(skipList).extractSorted([&](const KeyValue<std::size_t, std::size_t> &kv) {
+        CHECK(count == 0 || previous < kv.key);
+        previous = kv.key;
+        ++count;
+    });
+    CHECK_EQ(count, KEYS);
+}
+
+TEST_CASE ("HashTable") {
+    using namespace supermap;
+
+    using K = Key<3>;
+
+    HashTable<K, std::size_t, std::size_t> table(std::make_unique<XXHasher>());
+    std::map<std::string, std::size_t> expected;
+    std::mt19937 rnd(239);
+    auto key = [](std::size_t i) {
+        return K::fromString(std::string{static_cast<char>(i / 256), static_cast<char>(i % 256), 'k'});
+    };
+    for (std::size_t i = 0; i < 20000; ++i) {
+        std::size_t k = rnd() % 3000;
+        if (rnd() % 4 == 0) {
+            table.remove(key(k));
+            expected.erase(key(k).toString());
+        } else {
+            table.add(key(k), std::size_t{i});
+            expected[key(k).toString()] = i;
+        }
+    }
+    CHECK_EQ(table.getUpperSizeBound(), expected.size());
+    for (std::size_t k = 0; k < 3000; ++k) {
+        auto it = expected.find(key(k).toString());
+        CHECK_EQ(table.getValue(key(k)), it == expected.end() ? std::nullopt : std::optional{it->second});
+    }
+    auto extracted = std::move(table).extract();
+    CHECK_EQ(extracted.size(), expected.size());
+    CHECK(std::equal(extracted.begin(), extracted.end(), expected.begin(), [](const auto &kv, const auto &p) {
+        return kv.key.toString() == p.first && kv.value == p.second;
+    }));
+    CHECK_EQ(table.getUpperSizeBound(), 0);
+    CHECK_EQ(table.getValue(key(1)), std::nullopt);
+}
+
+TEST_CASE ("Supermap over HashTable") {
+    using namespace supermap;
+
+    using K = Key<2>;
+    using V = ByteArray<3>;
+    using I = std::size_t;
+
+    using SupermapBuilder = ShardedSupermapBuilder<K, V, I>;
+
+    auto superMap = SupermapBuilder::build(
+        3,
+        std::make_unique<XXHasher>(),
+        std::make_unique<HashTable<K, I, I>>(std::make_unique<XXHasher>()),
+        SupermapBuilder::BuildParameters{5, 0.5, "supermap", 1 / 32.0}
+    );
+    for (std::size_t i = 0; i < 500; ++i) {
+        superMap->add(makeKey2(i % 300), makeValue(i));
+    }
+    for (std::size_t i = 200; i < 500; ++i) {
+        CHECK_EQ(superMap->getValue(makeKey2(i % 300)), makeValue(i));
+    }
+    CHECK_EQ(superMap->contains(makeKey2(300)), false);
+}
+
 TEST_CASE ("Supermap simple") {
     using namespace supermap;
 
@@ -773,7 +1351,7 @@ TEST_CASE ("Supermap simple") {
     auto superMap = SupermapBuilder::build(
         5,
         std::make_unique<XXHasher>(),
-        std::make_unique<BST<K, I, I>>(),
+        std::make_unique<SkipList<K, I, I>>(),
         SupermapBuilder::BuildParameters{
             3,
             0.5,
@@ -808,3 +1386,490 @@ TEST_CASE ("Supermap simple") {
     CHECK_LE(superMap->getUpperSizeBound(), 9);
 }
 }
+
+TEST_CASE ("Supermap lookups during background shrink") {
+    using namespace supermap;
+
+    using K = Key<2>;
+    using V = ByteArray<3>;
+    using I = std::size_t;
+    using Builder = DefaultSupermap<K, V, I>;
+
+    auto key = [](std::size_t i) {
+        return K::fromString(std::string{static_cast<char>('a' + i / 26), static_cast<char>('a' + i % 26)});
+    };
+    auto value = [](std::size_t i) {
+        return V::fromString(std::to_string(100 + i));
+    };
+
+    typename Builder::BuildParameters params{4, 0.5, "supermap-background-shrink", 1 / 32.0};
+    params.backgroundShrink = true;
+    auto superMap = Builder::build(std::make_unique<BST<K, I, I>>(), params);
+
+    // Shrink is installed only by the next add, so right after the add, which starts it,
+    // old and overwritten values are looked up through the frozen generation.
+    std::vector<std::optional<V>> expected(20);
+    for (std::size_t i = 0; i < 120; ++i) {
+        superMap->add(key(i * 7 % expected.size()), value(i));
+        expected[i * 7 % expected.size()] = value(i);
+        for (std::size_t j = 0; j < expected.size(); ++j) {
+            CHECK_EQ(superMap->contains(key(j)), expected[j].has_value());
+            if (expected[j].has_value()) {
+                CHECK_EQ(superMap->getValue(key(j)), expected[j].value());
+            }
+        }
+    }
+}
+
+TEST_CASE ("WriteAheadLog replay") {
+    using namespace supermap;
+
+    auto fileManager = std::make_shared<io::RamFileManager>();
+    auto replayAll = [&]() {
+        io::WriteAheadLog<CharKV> log(fileManager, "log", io::WalSyncPolicy::never());
+        std::vector<CharKV> records;
+        log.replay([&](CharKV &&kv) { records.push_back(kv); });
+        return records;
+    };
+    CHECK(replayAll().empty());
+    {
+        io::WriteAheadLog<CharKV> log(fileManager, "log", io::WalSyncPolicy::everyOps(2));
+        log.append({'a', '1'});
+        log.append({'b', '2'});
+        log.append({'c', '3'});
+    }
+    CHECK_EQ(replayAll(), std::vector<CharKV>{{'a', '1'}, {'b', '2'}, {'c', '3'}});
+    fileManager->getOutputStream("log", true)->get() << 'd';
+    CHECK_EQ(replayAll(), std::vector<CharKV>{{'a', '1'}, {'b', '2'}, {'c', '3'}});
+    {
+        io::WriteAheadLog<CharKV> log(fileManager, "log", io::WalSyncPolicy::everyMillis(1));
+        log.replay([](CharKV &&) {});
+        log.append({'d', '4'});
+        log.sync();
+    }
+    CHECK_EQ(replayAll(), std::vector<CharKV>{{'a', '1'}, {'b', '2'}, {'c', '3'}, {'d', '4'}});
+    CHECK_THROWS_AS(io::WriteAheadLog<CharKV>(fileManager, "log", io::WalSyncPolicy::everyOps(0)),
+                    IllegalArgumentException);
+}
+
+TEST_CASE ("Supermap write-ahead log recovery") {
+    using namespace supermap;
+
+    using K = Key<2>;
+    using V = ByteArray<3>;
+    using I = std::size_t;
+
+    using SupermapBuilder = ShardedSupermapBuilder<K, V, I>;
+
+    const std::string folder = "supermap-write-ahead-log";
+    std::filesystem::remove_all(folder);
+    auto build = [&](bool persistent) {
+        typename SupermapBuilder::BuildParameters params{3, 0.5, folder, 1 / 32.0};
+        params.persistent = persistent;
+        params.writeAheadLog = io::WalSyncPolicy::everyOps(4);
+        return SupermapBuilder::build(2, std::make_unique<XXHasher>(), std::make_unique<BST<K, I, I>>(), params);
+    };
+    CHECK_THROWS_AS(build(false), IllegalArgumentException);
+    {
+        auto superMap = build(true);
+        for (std::size_t i = 0; i < 100; ++i) {
+            superMap->add(makeKey2(i), makeValue(i));
+        }
+        // simulate a crash: nothing is checkpointed, so items are restored from the log only
+        superMap.release();
+    }
+    {
+        auto superMap = build(true);
+        for (std::size_t i = 0; i < 100; ++i) {
+            CHECK_EQ(superMap->getValue(makeKey2(i)), makeValue(i));
+        }
+        superMap->add(makeKey2(0), makeValue(7));
+    }
+    {
+        auto superMap = build(true);
+        CHECK_EQ(superMap->getValue(makeKey2(0)), makeValue(7));
+        CHECK_EQ(superMap->getValue(makeKey2(99)), makeValue(99));
+        CHECK_EQ(superMap->contains(makeKey2(100)), false);
+    }
+    std::filesystem::remove_all(folder);
+}
+
+TEST_CASE ("Supermap manifest reopen") {
+    using namespace supermap;
+
+    using K = Key<2>;
+    using V = ByteArray<3>;
+    using I = std::size_t;
+
+    using SupermapBuilder = ShardedSupermapBuilder<K, V, I>;
+
+    const std::string folder = "supermap-manifest";
+    std::filesystem::remove_all(folder);
+    auto build = [&](bool writeAheadLog) {
+        typename SupermapBuilder::BuildParameters params{3, 0.5, folder, 1 / 32.0};
+        params.persistent = true;
+        params.filterKind = DefaultSupermap<K, V, I>::FilterKind::XOR;
+        if (writeAheadLog) {
+            params.writeAheadLog = io::WalSyncPolicy::everyOps(1);
+        }
+        return SupermapBuilder::build(2, std::make_unique<XXHasher>(), std::make_unique<BST<K, I, I>>(), params);
+    };
+    {
+        auto superMap = build(false);
+        for (std::size_t i = 0; i < 200; ++i) {
+            superMap->add(makeKey2(i % 150), makeValue(i));
+        }
+    }
+    {
+        auto superMap = build(false);
+        for (std::size_t i = 50; i < 200; ++i) {
+            CHECK_EQ(superMap->getValue(makeKey2(i % 150)), makeValue(i));
+        }
+        CHECK_EQ(superMap->contains(makeKey2(150)), false);
+        for (std::size_t i = 200; i < 300; ++i) {
+            superMap->add(makeKey2(i), makeValue(i));
+        }
+    }
+    {
+        auto superMap = build(true);
+        CHECK_EQ(superMap->getValue(makeKey2(0)), makeValue(150));
+        CHECK_EQ(superMap->getValue(makeKey2(299)), makeValue(299));
+        superMap->add(makeKey2(0), makeValue(7));
+    }
+    CHECK(std::any_of(
+        std::filesystem::directory_iterator(std::filesystem::path(folder) / "0"),
+        std::filesystem::directory_iterator(),
+        [](const auto &entry) { return entry.path().extension() == ".filter"; }
+    ));
+    {
+        auto superMap = build(true);
+        CHECK_EQ(superMap->getValue(makeKey2(0)), makeValue(7));
+        CHECK_EQ(superMap->getValue(makeKey2(250)), makeValue(250));
+        CHECK_EQ(superMap->contains(makeKey2(300)), false);
+    }
+    std::filesystem::remove_all(folder);
+}
+
+TEST_CASE ("Supermap checkpoint survives lost destructor") {
+    using namespace supermap;
+
+    using K = Key<2>;
+    using V = ByteArray<3>;
+    using I = std::size_t;
+    using Builder = DefaultSupermap<K, V, I>;
+
+    const std::string folder = "supermap-checkpoint";
+    std::filesystem::remove_all(folder);
+    auto build = [&]() {
+        typename Builder::BuildParameters params{3, 0.5, folder, 1 / 32.0};
+        params.persistent = true;
+        params.writeAheadLog = io::WalSyncPolicy::everyOps(1);
+        params.filterKind = Builder::FilterKind::BLOCKED_BLOOM;
+        return Builder::build(std::make_unique<BST<K, I, I>>(), params);
+    };
+    {
+        auto superMap = build();
+        for (std::size_t i = 0; i < 100; ++i) {
+            superMap->add(makeKey2(i), makeValue(i));
+        }
+        dynamic_cast<Supermap<K, V, I> &>(*superMap).checkpoint();
+        for (std::size_t i = 100; i < 120; ++i) {
+            superMap->add(makeKey2(i), makeValue(i));
+        }
+        CHECK(std::filesystem::exists(std::filesystem::path(folder) / "MANIFEST"));
+        // simulate a crash: storage files are left as they are, nothing is checkpointed
+        superMap.release();
+    }
+    {
+        auto superMap = build();
+        for (std::size_t i = 0; i < 120; ++i) {
+            CHECK_EQ(superMap->getValue(makeKey2(i)), makeValue(i));
+        }
+    }
+    std::filesystem::remove_all(folder);
+}
+
+TEST_CASE ("Supermap background memtable flush") {
+    using namespace supermap;
+
+    using K = Key<2>;
+    using V = ByteArray<3>;
+    using I = std::size_t;
+    using Builder = DefaultSupermap<K, V, I>;
+    using Smap = Supermap<K, V, I>;
+
+    typename Builder::BuildParameters params{4, 0.6, "supermap", 1 / 32.0};
+    params.maxImmutableMemtables = 2;
+    params.backgroundCompaction = true;
+    auto superMap = Builder::build(std::make_unique<SkipList<K, I, I>>(), params);
+    for (std::size_t i = 0; i < 600; ++i) {
+        superMap->add(makeKey2(i % 400), makeValue(i));
+        CHECK_EQ(superMap->getValue(makeKey2(i % 400)), makeValue(i));
+        if (i >= 10) {
+            CHECK_EQ(superMap->getValue(makeKey2((i - 10) % 400)), makeValue(i - 10));
+        }
+    }
+    for (std::size_t i = 200; i < 600; ++i) {
+        CHECK_EQ(superMap->getValue(makeKey2(i % 400)), makeValue(i));
+    }
+    CHECK_EQ(superMap->contains(makeKey2(400)), false);
+    CHECK(!dynamic_cast<Smap &>(*superMap).getFilterStats().storages.empty());
+}
+
+TEST_CASE ("Sharded supermap concurrent access") {
+    using namespace supermap;
+
+    using K = Key<2>;
+    using V = ByteArray<3>;
+    using I = std::size_t;
+    using SupermapBuilder = ShardedSupermapBuilder<K, V, I>;
+
+    auto superMap = SupermapBuilder::build(
+        4,
+        std::make_unique<XXHasher>(),
+        std::make_unique<BST<K, I, I>>(),
+        SupermapBuilder::BuildParameters{8, 0.5, "supermap", 1 / 32.0}
+    );
+    const std::size_t prefilled = 100;
+    const std::size_t threads = 4;
+    const std::size_t addedByThread = 100;
+    for (std::size_t i = 0; i < prefilled; ++i) {
+        superMap->add(makeKey2(i), makeValue(i));
+    }
+    std::atomic<std::size_t> mismatches = 0;
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            for (std::size_t j = 0; j < addedByThread; ++j) {
+                std::size_t i = prefilled + j * threads + t;
+                superMap->add(makeKey2(i), makeValue(i));
+            }
+        });
+        workers.emplace_back([&]() {
+            for (std::size_t round = 0; round < 5; ++round) {
+                for (std::size_t i = 0; i < prefilled; ++i) {
+                    if (!(superMap->getValue(makeKey2(i)) == makeValue(i))) {
+                        ++mismatches;
+                    }
+                }
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    CHECK_EQ(mismatches.load(), 0);
+    for (std::size_t i = 0; i < prefilled + threads * addedByThread; ++i) {
+        CHECK_EQ(superMap->getValue(makeKey2(i)), makeValue(i));
+    }
+}
+
+TEST_CASE ("MpscQueue") {
+    using namespace supermap;
+
+    const int producers = 4;
+    const int pushedByProducer = 10000;
+    MpscQueue<std::unique_ptr<int>> queue;
+    CHECK(queue.empty());
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p]() {
+            for (int i = 0; i < pushedByProducer; ++i) {
+                queue.push(std::make_unique<int>(i * producers + p));
+            }
+        });
+    }
+    std::vector<int> lastPopped(producers, -1);
+    int outOfOrder = 0;
+    for (int popped = 0; popped < producers * pushedByProducer;) {
+        std::optional<std::unique_ptr<int>> item = queue.pop();
+        if (!item.has_value()) {
+            std::this_thread::yield();
+            continue;
+        }
+        int &last = lastPopped[*item.value() % producers];
+        if (*item.value() / producers != last + 1) {
+            ++outOfOrder;
+        }
+        last = *item.value() / producers;
+        ++popped;
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    CHECK_EQ(outOfOrder, 0);
+    CHECK(queue.empty());
+    CHECK(!queue.pop().has_value());
+}
+
+TEST_CASE ("Sharded supermap executor") {
+    using namespace supermap;
+
+    using K = Key<2>;
+    using V = ByteArray<3>;
+    using I = std::size_t;
+    using SupermapBuilder = ShardedSupermapBuilder<K, V, I>;
+
+    auto superMap = SupermapBuilder::buildExecutor(
+        3,
+        std::make_unique<XXHasher>(),
+        std::make_unique<SkipList<K, I, I>>(),
+        SupermapBuilder::BuildParameters{8, 0.5, "supermap", 1 / 32.0},
+        false
+    );
+    const std::size_t threads = 4;
+    const std::size_t addedByThread = 100;
+    std::vector<std::thread> clients;
+    for (std::size_t t = 0; t < threads; ++t) {
+        clients.emplace_back([&, t]() {
+            std::vector<std::future<void>> added;
+            for (std::size_t j = 0; j < addedByThread; ++j) {
+                std::size_t i = j * threads + t;
+                added.push_back(superMap->addAsync(makeKey2(i), makeValue(i)));
+            }
+            for (auto &future : added) {
+                future.get();
+            }
+        });
+    }
+    for (auto &client : clients) {
+        client.join();
+    }
+    std::vector<std::future<std::optional<V>>> found;
+    for (std::size_t i = 0; i < threads * addedByThread; ++i) {
+        found.push_back(superMap->getValueAsync(makeKey2(i)));
+    }
+    for (std::size_t i = 0; i < found.size(); ++i) {
+        CHECK_EQ(found[i].get(), makeValue(i));
+    }
+    superMap->add(makeKey2(0), makeValue(1));
+    CHECK_EQ(superMap->getValue(makeKey2(0)), makeValue(1));
+    CHECK_EQ(superMap->contains(makeKey2(threads * addedByThread)), false);
+    CHECK_GE(superMap->getUpperSizeBound(), threads * addedByThread);
+    CHECK_THROWS_AS(superMap->remove(makeKey2(0)), NotImplementedException);
+}
+
+TEST_CASE ("Supermap multiGet") {
+    using namespace supermap;
+
+    using K = Key<3>;
+    using V = ByteArray<4>;
+    using I = std::size_t;
+    using Builder = DefaultSupermap<K, V, I>;
+    using SupermapBuilder = ShardedSupermapBuilder<K, V, I>;
+
+    auto key = [](std::size_t i) {
+        return K::fromString(std::string{static_cast<char>('a' + i / 676),
+                                         static_cast<char>('a' + i / 26 % 26),
+                                         static_cast<char>('a' + i % 26)});
+    };
+    auto value = [](std::size_t i) {
+        return V::fromString(std::to_string(1000 + i));
+    };
+    auto check = [&](KeyValueStorage<K, V, I> &storage) {
+        const std::size_t keys = 3000;
+        std::vector<std::optional<V>> expected(keys + 300);
+        for (std::size_t i = 0; i < 2 * keys; ++i) {
+            storage.add(key(i * 7 % keys), value(i));
+            expected[i * 7 % keys] = value(i);
+        }
+        std::mt19937 rnd(239);
+        std::vector<std::size_t> batchIds;
+        std::vector<K> batch;
+        for (std::size_t j = 0; j < 500; ++j) {
+            batchIds.push_back(rnd() % expected.size());
+            batch.push_back(key(batchIds.back()));
+        }
+        batchIds.push_back(batchIds.front());
+        batch.push_back(batch.front());
+        std::vector<std::optional<V>> values = storage.multiGet(batch);
+        CHECK_EQ(values.size(), batch.size());
+        for (std::size_t j = 0; j < batch.size(); ++j) {
+            CHECK_EQ(values[j], expected[batchIds[j]]);
+        }
+        CHECK_EQ(storage.multiGet({key(keys), key(0), key(keys + 1)}),
+                 std::vector<std::optional<V>>{std::nullopt, expected[0], std::nullopt});
+        CHECK(storage.multiGet({}).empty());
+    };
+
+    typename Builder::BuildParameters params{32, 0.5, "supermap-multiget", 1 / 32.0};
+    params.backgroundShrink = true;
+    check(*Builder::build(std::make_unique<SkipList<K, I, I>>(), params));
+    params.folderName = "supermap-multiget-sharded";
+    check(*SupermapBuilder::build(3, std::make_unique<XXHasher>(), std::make_unique<BST<K, I, I>>(), params));
+    params.folderName = "supermap-multiget-executor";
+    check(*SupermapBuilder::buildExecutor(3,
+                                          std::make_unique<XXHasher>(),
+                                          std::make_unique<SkipList<K, I, I>>(),
+                                          params,
+                                          false));
+}
+
+TEST_CASE ("Supermap monkey filter policy") {
+    using namespace supermap;
+
+    using K = Key<3>;
+    using V = ByteArray<1>;
+    using I = std::size_t;
+    using Builder = DefaultSupermap<K, V, I>;
+    using Smap = Supermap<K, V, I>;
+
+    auto key = [](std::size_t i) {
+        return K::fromString(std::string{
+            static_cast<char>('a' + i / 676), static_cast<char>('a' + i / 26 % 26), static_cast<char>('a' + i % 26)
+        });
+    };
+    auto value = [](std::size_t i) {
+        return V::fromString(std::string{static_cast<char>('a' + i % 26)});
+    };
+    const double bitsPerKey = 8;
+    typename Builder::BuildParameters params{64, 0.5, "supermap-monkey-filters", 1 / 32.0};
+    params.bitsPerKey = bitsPerKey;
+    params.monkeyFilterPolicy = true;
+    auto superMap = Builder::build(std::make_unique<BST<K, I, I>>(), params);
+    for (std::size_t i = 0; i < 5000; ++i) {
+        superMap->add(key(i), value(i));
+    }
+    for (std::size_t i = 0; i < 5000; i += 7) {
+        CHECK_EQ(superMap->getValue(key(i)), value(i));
+    }
+
+    auto stats = dynamic_cast<Smap &>(*superMap).getFilterStats();
+    CHECK(stats.storages.size() > 1);
+    std::size_t items = 0;
+    for (const auto &storage : stats.storages) {
+        items += storage.items;
+    }
+    if (!stats.storages.empty()) {
+        CHECK_LE(stats.storages.front().falsePositiveProbability, stats.storages.back().falsePositiveProbability);
+    }
+    CHECK_LE(static_cast<double>(stats.memoryBits), 1.05 * bitsPerKey * static_cast<double>(items));
+    double actualBitsPerKey = static_cast<double>(stats.memoryBits) / static_cast<double>(items);
+    double uniformFalsePositives = static_cast<double>(stats.storages.size()) * std::pow(0.6185, actualBitsPerKey);
+    CHECK_LE(stats.expectedFalsePositives, uniformFalsePositives);
+}
+
+TEST_CASE ("LazyFilter") {
+    using namespace supermap;
+
+    using K = Key<2>;
+
+    auto fileManager = std::make_shared<io::RamFileManager>();
+    BloomFilter<K> filter(1 / 32.0, std::make_unique<XXHasher>());
+    filter.reserve(10);
+    filter.add(K::fromString("ab"));
+    {
+        auto output = fileManager->getOutputStream("filter", false);
+        filter.save(output->get());
+        output->flush();
+    }
+
+    LazyFilter<K> lazy(fileManager, "filter", std::make_unique<BloomFilter<K>>(1 / 2.0, std::make_unique<XXHasher>()));
+    CHECK(!lazy.isLoaded());
+    CHECK_EQ(lazy.getMemoryBits(), 0);
+    CHECK(lazy.mightContain(K::fromString("ab")));
+    CHECK(lazy.isLoaded());
+    CHECK_EQ(lazy.getMemoryBits(), filter.getMemoryBits());
+    CHECK_EQ(lazy.mightContain(K::fromString("cd")), filter.mightContain(K::fromString("cd")));
+    CHECK_THROWS_AS(lazy.add(K::fromString("cd")), IllegalStateException);
+}
@@ -27,7 +27,11 @@ void stressTestSupermap(std::size_t iterations,
                         double part,
                         char alphabetBegin,
                         char alphabetEnd,
-                        bool check) {
+                        bool check,
+                        bool memoryMapped = false,
+                        std::shared_ptr<supermap::io::BlockCache> blockCache = nullptr,
+                        bool backgroundCompaction = false,
+                        bool backgroundShrink = false) {
     using namespace supermap;
 
     using K = Key<KeyLen>;
@@ -44,7 +48,11 @@ void stressTestSupermap(std::size_t iterations,
             batchSize,
             part,
             "supermap",
-            1 / 32.0
+            1 / 32.0,
+            memoryMapped,
+            blockCache,
+            backgroundCompaction,
+            backgroundShrink
         }
     );
 
@@ -58,7 +66,11 @@ void stressTestSupermap(std::size_t iterations,
                 batchSize,
                 part,
                 "supermap-other",
-                1 / 32.0
+                1 / 32.0,
+                memoryMapped,
+                blockCache,
+                backgroundCompaction,
+                backgroundShrink
             }
         );
 
@@ -130,6 +142,25 @@ TEST_CASE("Supermap Stress 4") {
     stressTestSupermap<2, 2>(20000, timeSeed(), 507, 0.02, 'a', 'z', true);
 }
 
+TEST_CASE("Supermap Stress memory mapped") {
+    stressTestSupermap<3, 4>(10000, timeSeed(), 7, 0.12, '0', '3', true, true);
+}
+
+TEST_CASE("Supermap Stress block cache") {
+    auto blockCache = std::make_shared<supermap::io::BlockCache>(64 * 1024);
+    stressTestSupermap<3, 4>(10000, timeSeed(), 7, 0.12, '0', '3', true, false, blockCache);
+}
+
+TEST_CASE("Supermap Stress background compaction") {
+    stressTestSupermap<3, 4>(10000, timeSeed(), 7, 0.12, '0', '3', true, false, nullptr, true);
+    stressTestSupermap<2, 2>(20000, timeSeed(), 3, 0.9, 'a', 'z', true, false, nullptr, true);
+}
+
+TEST_CASE("Supermap Stress background shrink") {
+    stressTestSupermap<3, 4>(10000, timeSeed(), 7, 0.12, '0', '3', true, false, nullptr, false, true);
+    stressTestSupermap<2, 2>(20000, timeSeed(), 3, 0.3, 'a', 'z', true, false, nullptr, true, true);
+}
+
 }
 
 //TEST_SUITE("Supermap Stress Profiling") {